@@ -0,0 +1,162 @@
+#include "simxBench.h"
+#include "simxUtils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define BENCH_COMPRESSION_BUFFERS 3000
+#define BENCH_COMPRESSION_MAX_SIZE 100000
+#define BENCH_COMPRESSION_DEPTH_SIZE (4*1024*1024)
+#define BENCH_COMPRESSION_ITERATIONS 10
+
+int benchLz4Decompress(const char* source,int sourceSize,char* dest,int destSize)
+{ // straight from the LZ4 block format description, including its end of block rules. Returns the decoded size, or -1 if the block is not valid
+    const BYTE* ip=(const BYTE*)source;
+    const BYTE* ipEnd=ip+sourceSize;
+    BYTE* op=(BYTE*)dest;
+    BYTE* opEnd=op+destSize;
+    while (ip<ipEnd)
+    {
+        int token=*ip++;
+        int literalLength=token>>4;
+        if (literalLength==15)
+        {
+            int b=255;
+            while (b==255)
+            {
+                if (ip>=ipEnd)
+                    return(-1);
+                b=*ip++;
+                literalLength+=b;
+            }
+        }
+        if ((literalLength>ipEnd-ip)||(literalLength>opEnd-op))
+            return(-1);
+        memcpy(op,ip,literalLength);
+        ip+=literalLength;
+        op+=literalLength;
+        if (ip==ipEnd)
+            break; // the last sequence only has literals
+        if (ipEnd-ip<2)
+            return(-1);
+        int offset=ip[0]|(ip[1]<<8);
+        ip+=2;
+        if ((offset==0)||(offset>op-(BYTE*)dest))
+            return(-1);
+        int matchLength=(token&15)+4;
+        if ((token&15)==15)
+        {
+            int b=255;
+            while (b==255)
+            {
+                if (ip>=ipEnd)
+                    return(-1);
+                b=*ip++;
+                matchLength+=b;
+            }
+        }
+        if ((opEnd-op<12)||(matchLength>opEnd-op-5))
+            return(-1); // the last match starts at least 12 bytes before the end, the last 5 bytes are literals
+        for (int i=0;i<matchLength;i++)
+            op[i]=op[i-offset]; // the match can overlap what it writes
+        op+=matchLength;
+    }
+    return(int(op-(BYTE*)dest));
+}
+
+static void _fillBuffer(std::vector<char>& buffer,int kind)
+{
+    for (size_t i=0;i<buffer.size();i++)
+    {
+        switch (kind)
+        {
+            case 0: // incompressible
+                buffer[i]=char(rand());
+                break;
+            case 1:
+                buffer[i]=0;
+                break;
+            case 2: // small alphabet
+                buffer[i]=char(rand()%4);
+                break;
+            case 3: // short repeated pattern
+                buffer[i]=((i<300)?char(rand()):buffer[i-1-(buffer.size()%300)]);
+                break;
+            case 4: // runs of random length
+                buffer[i]=(((i==0)||(rand()%20==0))?char(rand()):buffer[i-1]);
+                break;
+            default: // copies of earlier data, also from beyond the 64 KB window
+                if ((i>100)&&(rand()%50==0))
+                {
+                    size_t from=rand()%i;
+                    size_t n=rand()%200;
+                    for (size_t j=0;(j<n)&&(i<buffer.size());j++)
+                        buffer[i++]=buffer[from+j];
+                    i--;
+                }
+                else
+                    buffer[i]=char(rand());
+                break;
+        }
+    }
+}
+
+bool benchCompression()
+{
+    printf("LZ4 compression:\n");
+    srand(1);
+    bool ok=true;
+    int compressedCnt=0;
+    std::vector<char> buffer;
+    std::vector<char> compressed;
+    std::vector<char> decoded;
+    for (int i=0;i<BENCH_COMPRESSION_BUFFERS;i++)
+    {
+        int size=1+rand()%BENCH_COMPRESSION_MAX_SIZE;
+        if (i<100)
+            size=1+i; // all the tiny sizes
+        buffer.resize(size);
+        _fillBuffer(buffer,i%6);
+        // With the worst case bound the block always fits. With less room, lz4Compress gives up without writing past it:
+        int bound=size+size/255+16;
+        int capacities[2]={bound,size/2};
+        for (int c=0;c<2;c++)
+        {
+            compressed.assign(capacities[c]+16,char(0xa5));
+            int compressedSize=lz4Compress(&buffer[0],size,&compressed[0],capacities[c]);
+            for (int j=capacities[c];j<capacities[c]+16;j++)
+                ok=ok&&(compressed[j]==char(0xa5));
+            if (compressedSize==0)
+            {
+                ok=ok&&(c==1);
+                continue;
+            }
+            decoded.assign(size+1,0);
+            ok=ok&&(compressedSize<=capacities[c])&&(benchLz4Decompress(&compressed[0],compressedSize,&decoded[0],size)==size);
+            decoded.resize(size);
+            ok=ok&&(decoded==buffer);
+            if (c==1)
+                compressedCnt++;
+        }
+    }
+    printf("    %-40s %8d of %d\n","random buffers compressed by half",compressedCnt,BENCH_COMPRESSION_BUFFERS);
+
+    // A depth-like buffer: smooth floats
+    buffer.resize(BENCH_COMPRESSION_DEPTH_SIZE);
+    float* depth=(float*)&buffer[0];
+    for (int i=0;i<BENCH_COMPRESSION_DEPTH_SIZE/4;i++)
+        depth[i]=0.5f+float((i/256)%64)/256.0f;
+    compressed.resize(BENCH_COMPRESSION_DEPTH_SIZE);
+    int compressedSize=0;
+    double t=getBenchTime();
+    for (int i=0;i<BENCH_COMPRESSION_ITERATIONS;i++)
+        compressedSize=lz4Compress(&buffer[0],BENCH_COMPRESSION_DEPTH_SIZE,&compressed[0],BENCH_COMPRESSION_DEPTH_SIZE);
+    printBenchThroughput("lz4Compress (depth buffer)",double(BENCH_COMPRESSION_DEPTH_SIZE)*BENCH_COMPRESSION_ITERATIONS,getBenchTime()-t);
+    printf("    %-40s %8.2f %%\n","compressed size",100.0*double(compressedSize)/double(BENCH_COMPRESSION_DEPTH_SIZE));
+    decoded.resize(BENCH_COMPRESSION_DEPTH_SIZE);
+    ok=ok&&(compressedSize>0)&&(benchLz4Decompress(&compressed[0],compressedSize,&decoded[0],BENCH_COMPRESSION_DEPTH_SIZE)==BENCH_COMPRESSION_DEPTH_SIZE)&&(decoded==buffer);
+    if (!ok)
+        printf("    compressed data doesn't decode to the input!\n");
+    return(ok);
+}
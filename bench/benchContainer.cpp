@@ -0,0 +1,201 @@
+#include "simxBench.h"
+#include "simxContainer.h"
+#include "v_repLib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#define BENCH_CONTAINER_ROUNDS 10
+#define BENCH_PARTIAL_PURE_DATA_SIZE (1024*1024)
+#define BENCH_PARTIAL_PART_SIZE 1000
+
+class CBenchContainer : public CSimxContainer
+{ // input container of a message with many commands, 3 of 4 are oneshot
+public:
+    CBenchContainer(int commandCount) : CSimxContainer(true)
+    {
+        setOtherSideIsBigEndian(false);
+        for (int i=0;i<commandCount;i++)
+        {
+            int mode=simx_opmode_oneshot;
+            if ((i%4)==0)
+                mode=simx_opmode_continuous;
+            addCommand(new CSimxCmd(simx_cmd_get_joint_position+mode,0,4,(char*)&i),false);
+        }
+    }
+
+    void removeNonContinuousCommands()
+    {
+        _removeNonContinuousCommands();
+    }
+
+    void eraseNonContinuousCommands()
+    { // previous removal, for comparison: erase inside the loop
+        for (unsigned int i=0;i<_allCommands.size();i++)
+        {
+            if (_allCommands[i]->getOperationMode()!=simx_opmode_continuous)
+            {
+                delete _allCommands[i];
+                _allCommands.erase(_allCommands.begin()+i);
+                i--;
+            }
+        }
+        _rebuildCommandIndex();
+    }
+
+    bool isContinuousCommandKept(int handle)
+    { // adding a command that is already there must replace it
+        int cnt=getCommandCount();
+        addCommand(new CSimxCmd(simx_cmd_get_joint_position+simx_opmode_continuous,0,4,(char*)&handle),false);
+        return(getCommandCount()==cnt);
+    }
+};
+
+bool benchContainerRemoval()
+{
+    printf("Removal of oneshot commands (1 of 4 commands is streaming):\n");
+    bool ok=true;
+    int counts[3]={2500,10000,40000};
+    for (int c=0;c<3;c++)
+    {
+        double compacting=0.0;
+        double erasing=0.0;
+        for (int r=0;r<BENCH_CONTAINER_ROUNDS;r++)
+        {
+            CBenchContainer container(counts[c]);
+            double t=getBenchTime();
+            container.removeNonContinuousCommands();
+            compacting+=getBenchTime()-t;
+            ok=ok&&(container.getCommandCount()==counts[c]/4)&&container.isContinuousCommandKept(counts[c]-4)&&(!container.isContinuousCommandKept(1));
+
+            CBenchContainer reference(counts[c]);
+            t=getBenchTime();
+            reference.eraseNonContinuousCommands();
+            erasing+=getBenchTime()-t;
+        }
+        printf("    %6d commands: %8.3f ms, erase in loop (previous): %8.3f ms\n",counts[c],compacting*1000.0/BENCH_CONTAINER_ROUNDS,erasing*1000.0/BENCH_CONTAINER_ROUNDS);
+    }
+    if (!ok)
+        printf("    wrong commands kept!\n");
+    return(ok);
+}
+
+class CBenchPartialContainer : public CSimxContainer
+{ // input container that reassembles the parts of a split command: handle as command data, then the pure data
+public:
+    CBenchPartialContainer() : CSimxContainer(true)
+    {
+    }
+
+    char* addPart(const std::vector<char>& pureData,int offset,int size,int fullPureDataSize)
+    {
+        std::vector<char> part(SIMX_SUBHEADER_SIZE+4+size,char(0xa5)); // pure data outside of pureData stays garbage
+        int handle=42;
+        ((int*)&part[simx_cmdheaderoffset_mem_size])[0]=int(part.size());
+        ((int*)&part[simx_cmdheaderoffset_full_mem_size])[0]=SIMX_SUBHEADER_SIZE+4+fullPureDataSize;
+        ((WORD*)&part[simx_cmdheaderoffset_pdata_offset0])[0]=4;
+        ((int*)&part[simx_cmdheaderoffset_pdata_offset1])[0]=offset;
+        ((int*)&part[simx_cmdheaderoffset_cmd])[0]=simx_cmd_get_joint_position+simx_opmode_oneshot_split;
+        memcpy(&part[SIMX_SUBHEADER_SIZE],&handle,4);
+        for (int i=0;i<size;i++)
+        {
+            if ((offset+i>=0)&&(offset+i<int(pureData.size())))
+                part[SIMX_SUBHEADER_SIZE+4+i]=pureData[offset+i];
+        }
+        return(addPartialCommand(&part[0],false));
+    }
+
+    int getPartialCommandCount()
+    {
+        return(int(_partialCommands.size()));
+    }
+};
+
+static bool _isReassembledCommand(char* cmd,const std::vector<char>& pureData)
+{ // deletes cmd
+    if (cmd==NULL)
+        return(false);
+    bool ok=(((int*)(cmd+simx_cmdheaderoffset_mem_size))[0]==SIMX_SUBHEADER_SIZE+4+int(pureData.size()));
+    ok=ok&&(((int*)(cmd+SIMX_SUBHEADER_SIZE))[0]==42)&&(memcmp(cmd+SIMX_SUBHEADER_SIZE+4,&pureData[0],pureData.size())==0);
+    delete[] cmd;
+    return(ok);
+}
+
+bool benchPartialCommands()
+{
+    printf("Reassembly of split commands (%d KB in %d byte parts):\n",BENCH_PARTIAL_PURE_DATA_SIZE/1024,BENCH_PARTIAL_PART_SIZE);
+    srand(1);
+    std::vector<char> pureData(BENCH_PARTIAL_PURE_DATA_SIZE);
+    for (size_t i=0;i<pureData.size();i++)
+        pureData[i]=char(rand());
+    std::vector<std::pair<int,int> > parts; // offset, size
+    for (int off=0;off<BENCH_PARTIAL_PURE_DATA_SIZE;off+=BENCH_PARTIAL_PART_SIZE)
+        parts.push_back(std::make_pair(off,std::min(BENCH_PARTIAL_PART_SIZE,BENCH_PARTIAL_PURE_DATA_SIZE-off)));
+    bool ok=true;
+
+    // In order:
+    CBenchPartialContainer container;
+    double t=getBenchTime();
+    char* cmd=NULL;
+    for (size_t i=0;i<parts.size();i++)
+    {
+        cmd=container.addPart(pureData,parts[i].first,parts[i].second,BENCH_PARTIAL_PURE_DATA_SIZE);
+        ok=ok&&((cmd==NULL)==(i+1<parts.size()));
+    }
+    printBenchThroughput("in order",double(BENCH_PARTIAL_PURE_DATA_SIZE),getBenchTime()-t);
+    ok=_isReassembledCommand(cmd,pureData)&&ok;
+
+    // Out of order, with duplicated parts and parts that overlap others. The command completes exactly when everything was received:
+    std::vector<std::pair<int,int> > shuffled(parts);
+    for (int i=0;i<200;i++)
+        shuffled.push_back(parts[rand()%parts.size()]);
+    for (int i=0;i<200;i++)
+    {
+        int off=rand()%BENCH_PARTIAL_PURE_DATA_SIZE;
+        shuffled.push_back(std::make_pair(off,std::min(1+rand()%(3*BENCH_PARTIAL_PART_SIZE),BENCH_PARTIAL_PURE_DATA_SIZE-off)));
+    }
+    for (size_t i=shuffled.size()-1;i>0;i--)
+        std::swap(shuffled[i],shuffled[rand()%(i+1)]);
+    std::vector<bool> received(BENCH_PARTIAL_PURE_DATA_SIZE,false);
+    int receivedCnt=0;
+    size_t lastPart=0;
+    for (;receivedCnt<BENCH_PARTIAL_PURE_DATA_SIZE;lastPart++)
+    {
+        for (int j=shuffled[lastPart].first;j<shuffled[lastPart].first+shuffled[lastPart].second;j++)
+        {
+            if (!received[j])
+                receivedCnt++;
+            received[j]=true;
+        }
+    }
+    lastPart--;
+    cmd=NULL;
+    t=getBenchTime();
+    for (size_t i=0;(i<shuffled.size())&&(cmd==NULL);i++)
+    {
+        cmd=container.addPart(pureData,shuffled[i].first,shuffled[i].second,BENCH_PARTIAL_PURE_DATA_SIZE);
+        ok=ok&&((cmd==NULL)==(i<lastPart));
+    }
+    printBenchThroughput("out of order, duplicated, overlapping",double(BENCH_PARTIAL_PURE_DATA_SIZE),getBenchTime()-t);
+    ok=_isReassembledCommand(cmd,pureData)&&ok;
+    ok=ok&&(container.getPartialCommandCount()==0);
+
+    // Parts outside of the full size are ignored (ASan checks that nothing is written out of bounds):
+    ok=ok&&(container.addPart(pureData,BENCH_PARTIAL_PURE_DATA_SIZE-10,20,BENCH_PARTIAL_PURE_DATA_SIZE)==NULL); // past the end
+    ok=ok&&(container.addPart(pureData,-10,20,BENCH_PARTIAL_PURE_DATA_SIZE)==NULL);
+    ok=ok&&(container.addPart(pureData,0,20,10)==NULL); // larger than the full command
+    ok=ok&&(container.addPart(pureData,0,0,-4)==NULL); // the full command can't even hold the command data
+    ok=ok&&(container.getPartialCommandCount()==0);
+    // ... and don't disturb a command that is being reassembled:
+    for (size_t i=0;i<parts.size();i++)
+    {
+        cmd=container.addPart(pureData,parts[i].first,parts[i].second,BENCH_PARTIAL_PURE_DATA_SIZE);
+        if (i==parts.size()/2)
+            ok=ok&&(container.addPart(pureData,BENCH_PARTIAL_PURE_DATA_SIZE-BENCH_PARTIAL_PART_SIZE/2,BENCH_PARTIAL_PART_SIZE,BENCH_PARTIAL_PURE_DATA_SIZE)==NULL);
+    }
+    ok=_isReassembledCommand(cmd,pureData)&&ok;
+    if (!ok)
+        printf("    split commands not reassembled correctly!\n");
+    return(ok);
+}
@@ -0,0 +1,131 @@
+#include "simxBench.h"
+#include "simxImage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#define BENCH_IMAGE_CHECK_SIZES 200 // covers the tails of all SIMD block sizes
+#define BENCH_IMAGE_BYTES_PER_RUN 300000000
+
+static const char* _levelNames[4]={"scalar","sse2","ssse3","avx2"};
+
+static void _referenceRgbToGray(const BYTE* rgb,BYTE* gray,int pixelCount)
+{
+    for (int i=0;i<pixelCount;i++)
+        gray[i]=BYTE((rgb[3*i+0]+rgb[3*i+1]+rgb[3*i+2])/3);
+}
+
+static void _referenceDepthToWord(const float* depth,WORD* dest,int count)
+{
+    for (int i=0;i<count;i++)
+    {
+        float v=depth[i];
+        if (isnan(v)||(v<0.0f))
+            v=0.0f;
+        if (v>1.0f)
+            v=1.0f;
+        dest[i]=WORD(lrintf(v*65535.0f));
+    }
+}
+
+static float _getCheckDepth(int i)
+{ // random values in [0;1], with out of range values, NaNs and the bounds
+    switch (rand()%16)
+    {
+        case 0: return(NAN);
+        case 1: return(-0.5f);
+        case 2: return(1.5f);
+        case 3: return(0.0f);
+        case 4: return(1.0f);
+        case 5: return((float(i%65536)+0.5f)/65535.0f);
+    }
+    return(float(rand())/float(RAND_MAX));
+}
+
+static bool _checkKernels()
+{ // the kernels in use must give exactly the reference results, for any size and alignment
+    for (int n=0;n<BENCH_IMAGE_CHECK_SIZES;n++)
+    {
+        for (int offset=0;offset<2;offset++)
+        {
+            std::vector<BYTE> rgb(offset+3*n);
+            for (size_t i=0;i<rgb.size();i++)
+                rgb[i]=BYTE(rand());
+            if (n==BENCH_IMAGE_CHECK_SIZES-1)
+            { // saturated values: the largest sums
+                for (size_t i=0;i<rgb.size();i++)
+                    rgb[i]=BYTE(255-(i%3));
+            }
+            std::vector<BYTE> gray(offset+n,0);
+            std::vector<BYTE> grayRef(offset+n,0);
+            convertRgbToGray(rgb.data()+offset,gray.data()+offset,n);
+            _referenceRgbToGray(rgb.data()+offset,grayRef.data()+offset,n);
+            if (gray!=grayRef)
+            {
+                printf("    convertRgbToGray differs from the reference for %d pixels (offset %d)\n",n,offset);
+                return(false);
+            }
+
+            std::vector<float> depth(offset+n);
+            for (size_t i=0;i<depth.size();i++)
+                depth[i]=_getCheckDepth(int(i));
+            std::vector<WORD> words(offset+n,0);
+            std::vector<WORD> wordsRef(offset+n,0);
+            quantizeDepthToWord(depth.data()+offset,words.data()+offset,n);
+            _referenceDepthToWord(depth.data()+offset,wordsRef.data()+offset,n);
+            if (words!=wordsRef)
+            {
+                printf("    quantizeDepthToWord differs from the reference for %d values (offset %d)\n",n,offset);
+                return(false);
+            }
+        }
+    }
+    return(true);
+}
+
+bool benchImageKernels()
+{
+    printf("Image kernels (checked against the scalar reference, then timed per frame):\n");
+    bool ok=true;
+    int resolutions[4][2]={{256,256},{640,480},{1280,720},{1920,1080}};
+    for (int level=SIMX_CPU_SCALAR;level<=SIMX_CPU_AVX2;level++)
+    {
+        if (setImageKernelLevel(level)!=level)
+        {
+            printf("    %-6s not supported by this CPU\n",_levelNames[level]);
+            continue;
+        }
+        bool levelOk=_checkKernels();
+        ok=ok&&levelOk;
+        printf("    %-6s check %s\n",_levelNames[level],levelOk?"passed":"FAILED");
+        for (int r=0;r<4;r++)
+        {
+            int n=resolutions[r][0]*resolutions[r][1];
+            std::vector<BYTE> rgb(3*n);
+            std::vector<BYTE> gray(n);
+            std::vector<float> depth(n);
+            std::vector<WORD> words(n);
+            for (int i=0;i<n;i++)
+            {
+                rgb[3*i+0]=BYTE(i);
+                rgb[3*i+1]=BYTE(i>>8);
+                rgb[3*i+2]=BYTE(i*7);
+                depth[i]=float(i%1000)/1000.0f;
+            }
+            int iterations=BENCH_IMAGE_BYTES_PER_RUN/(3*n);
+            double t=getBenchTime();
+            for (int i=0;i<iterations;i++)
+                convertRgbToGray(rgb.data(),gray.data(),n);
+            double grayTime=(getBenchTime()-t)/iterations;
+            t=getBenchTime();
+            for (int i=0;i<iterations;i++)
+                quantizeDepthToWord(depth.data(),words.data(),n);
+            double depthTime=(getBenchTime()-t)/iterations;
+            printf("        %4dx%-4d gray: %8.1f us, depth to 16 bits: %8.1f us\n",resolutions[r][0],resolutions[r][1],grayTime*1000000.0,depthTime*1000000.0);
+        }
+    }
+    setImageKernelLevel(SIMX_CPU_AVX2); // back to the best kernels
+    return(ok);
+}
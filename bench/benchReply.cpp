@@ -0,0 +1,74 @@
+#include "simxBench.h"
+#include "simxCmd.h"
+#include "v_repLib.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_REPLY_RESX 640
+#define BENCH_REPLY_RESY 480
+#define BENCH_REPLY_ITERATIONS 200
+
+bool benchReplyBuilding()
+{ // a 640x480 RGB image reply (resolution + pixels), serialized like CSimxContainer does it
+    printf("Reply building (%dx%d RGB image):\n",BENCH_REPLY_RESX,BENCH_REPLY_RESY);
+    int pureDataSize=8+BENCH_REPLY_RESX*BENCH_REPLY_RESY*3;
+    char* pureData=new char[pureDataSize];
+    for (int i=0;i<pureDataSize;i++)
+        pureData[i]=char(i*7);
+    int handle=42;
+    CSimxCmd* cmd=new CSimxCmd(simx_cmd_get_vision_sensor_image_rgb+simx_opmode_continuous,0,4,(char*)&handle);
+    cmd->setDataReply_custom_copyBuffer(pureData,pureDataSize,true);
+
+    std::vector<char> reply;
+    double t=getBenchTime();
+    for (int i=0;i<BENCH_REPLY_ITERATIONS;i++)
+    {
+        reply.clear();
+        cmd->appendYourData(reply,false);
+    }
+    printBenchThroughput("appendYourData",double(reply.size())*BENCH_REPLY_ITERATIONS,getBenchTime()-t);
+
+    // Previous serialization, for comparison: one push_back per byte
+    std::vector<char> reference;
+    t=getBenchTime();
+    for (int i=0;i<BENCH_REPLY_ITERATIONS;i++)
+    {
+        reference.clear();
+        for (size_t j=0;j<reply.size();j++)
+            reference.push_back(reply[j]);
+    }
+    printBenchThroughput("push_back per byte (previous)",double(reply.size())*BENCH_REPLY_ITERATIONS,getBenchTime()-t);
+
+    t=getBenchTime();
+    for (int i=0;i<BENCH_REPLY_ITERATIONS;i++)
+        delete cmd->copyYourself();
+    printBenchThroughput("copyYourself",double(pureDataSize)*BENCH_REPLY_ITERATIONS,getBenchTime()-t);
+
+    // A streamed reply: each pass builds a new reply from the command's identity, serializes it, and deletes it.
+    // Once steady, the command and its pure data come from the command pool
+    long allocations=0;
+    for (int i=0;i<BENCH_REPLY_ITERATIONS;i++)
+    {
+        if (i==BENCH_REPLY_ITERATIONS/2)
+            allocations=getBenchAllocationCount();
+        CSimxCmd* retCmd=cmd->copyYourIdentity();
+        retCmd->setDataReply_custom_copyBuffer(pureData,pureDataSize,true);
+        reply.clear();
+        retCmd->appendYourData(reply,false);
+        delete retCmd;
+    }
+    allocations=getBenchAllocationCount()-allocations;
+    printf("    %-40s %8ld\n","allocations per streamed reply",allocations/(BENCH_REPLY_ITERATIONS/2));
+
+    bool ok=(allocations==0)&&(int(reply.size())==cmd->getYourDataSize());
+    CSimxCmd* copy=cmd->copyYourself();
+    std::vector<char> copyReply;
+    copy->appendYourData(copyReply,false);
+    ok=ok&&(copyReply==reply);
+    delete copy;
+    delete cmd;
+    delete[] pureData;
+    if (!ok)
+        printf("    reply or copy mismatch, or allocations!\n");
+    return(ok);
+}
@@ -0,0 +1,276 @@
+#include "simxBench.h"
+#include "simxCmd.h"
+#include "v_repLib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_STREAM_DELTA_PASSES 60
+
+class CBenchStreamCmd : public CSimxCmd
+{ // a streaming command whose replies are encoded like execute does it, at the given time (in ms)
+public:
+    CBenchStreamCmd(int commandID,int handle) : CSimxCmd(commandID+simx_opmode_continuous,0,4,(char*)&handle)
+    {
+    }
+
+    bool encode(CSimxCmd* retCmd,int currentTime,BYTE& status,std::vector<char>& pureData)
+    { // returns false if the reply is not sent. Otherwise status and pureData are what the client receives
+        retCmd=_encodeReply(retCmd,currentTime,false);
+        if (retCmd==NULL)
+            return(false);
+        std::vector<char> reply;
+        retCmd->appendYourData(reply,false);
+        delete retCmd;
+        status=BYTE(reply[simx_cmdheaderoffset_status]);
+        int pureDataOffset=SIMX_SUBHEADER_SIZE+((WORD*)&reply[simx_cmdheaderoffset_pdata_offset0])[0];
+        pureData.assign(reply.begin()+pureDataOffset,reply.end());
+        return(true);
+    }
+};
+
+static bool _checkSendOnlyOnChange()
+{ // unchanged replies are dropped, a keep-alive marker goes out after SIMX_SENDONLYONCHANGE_KEEPALIVE ms without any reply
+    CBenchStreamCmd cmd(simx_cmd_get_joint_position,7);
+    cmd.setSendOnlyOnChange(true);
+    BYTE status;
+    std::vector<char> pureData;
+    int sent=0;
+    int keepAlives=0;
+    int changes=0;
+    bool ok=true;
+    for (int t=0;t<3*SIMX_SENDONLYONCHANGE_KEEPALIVE;t+=10)
+    {
+        float value=1.0f;
+        if (t>=SIMX_SENDONLYONCHANGE_KEEPALIVE+500)
+            value=2.0f; // changes once, in the middle of the second keep-alive period
+        CSimxCmd* retCmd=cmd.copyYourIdentity();
+        retCmd->setDataReply_1float(value,true,false);
+        if (!cmd.encode(retCmd,t,status,pureData))
+            continue;
+        sent++;
+        if (status&SIMX_CMDSTATUS_UNCHANGED)
+        {
+            keepAlives++;
+            ok=ok&&(pureData.size()==0)&&((t==SIMX_SENDONLYONCHANGE_KEEPALIVE)||(t==2*SIMX_SENDONLYONCHANGE_KEEPALIVE+500));
+        }
+        else
+        {
+            changes++;
+            ok=ok&&(pureData.size()==4)&&(memcmp(&pureData[0],&value,4)==0);
+        }
+    }
+    // first reply, keep-alive at 1000 ms, change at 1500 ms, keep-alive at 2500 ms:
+    ok=ok&&(changes==2)&&(keepAlives==2)&&(sent==4);
+
+    // an error reply with the same data is a change:
+    CSimxCmd* retCmd=cmd.copyYourIdentity();
+    retCmd->setDataReply_1float(2.0f,false,false);
+    ok=ok&&cmd.encode(retCmd,3*SIMX_SENDONLYONCHANGE_KEEPALIVE,status,pureData)&&((status&1)!=0)&&((status&SIMX_CMDSTATUS_UNCHANGED)==0);
+    printf("    %-40s %8d of %d\n","send-only-on-change replies sent",sent,3*SIMX_SENDONLYONCHANGE_KEEPALIVE/10);
+    if (!ok)
+        printf("    unchanged replies not suppressed as expected!\n");
+    return(ok);
+}
+
+static void _setImageResolution(std::vector<char>& frame,int resX,int resY)
+{ // an RGB image reply with random pixels
+    frame.resize(8+resX*resY*3);
+    ((int*)&frame[0])[0]=resX;
+    ((int*)&frame[0])[1]=resY;
+    for (size_t i=8;i<frame.size();i++)
+        frame[i]=char(rand());
+}
+
+static bool _applyImageReply(std::vector<char>& clientFrame,BYTE status,const std::vector<char>& pureData)
+{ // what a client does with an image reply: a keyframe replaces its frame, a delta patches the changed tiles. Returns false if the delta doesn't fit
+    if ((status&SIMX_CMDSTATUS_DELTA)==0)
+    {
+        clientFrame=pureData;
+        return(true);
+    }
+    if ((clientFrame.size()<8)||(pureData.size()<16)||(memcmp(&pureData[0],&clientFrame[0],8)!=0))
+        return(false);
+    int tileSize=((int*)&pureData[8])[0];
+    int tileCnt=((int*)&pureData[8])[1];
+    int pixelDataSize=int(clientFrame.size())-8;
+    size_t off=16;
+    for (int i=0;i<tileCnt;i++)
+    {
+        if (off+4>pureData.size())
+            return(false);
+        int tileOff=((int*)&pureData[off])[0]*tileSize;
+        int n=pixelDataSize-tileOff;
+        if (n>tileSize)
+            n=tileSize;
+        if ((tileOff<0)||(n<=0)||(off+4+n>pureData.size()))
+            return(false);
+        memcpy(&clientFrame[8+tileOff],&pureData[off+4],n);
+        off+=4+n;
+    }
+    return(off==pureData.size());
+}
+
+static bool _checkDeltaEncoding()
+{ // the client's frame, patched with the deltas, must always be the image the server read
+    CBenchStreamCmd cmd(simx_cmd_get_vision_sensor_image_rgb,42);
+    cmd.setDeltaEncoding(true);
+    srand(1);
+    std::vector<char> frame;
+    std::vector<char> clientFrame;
+    std::vector<char> pureData;
+    BYTE status;
+    int timeOffset=0;
+    int deltas=0;
+    double deltaBytes=0.0;
+    double frameBytes=0.0;
+    bool ok=true;
+    for (int pass=0;pass<BENCH_STREAM_DELTA_PASSES;pass++)
+    {
+        bool keyframeExpected=false;
+        bool error=false;
+        if (pass==0)
+        {
+            _setImageResolution(frame,128,96);
+            keyframeExpected=true;
+        }
+        else if (pass==20)
+        { // unchanged: a delta without tiles
+        }
+        else if (pass==21)
+        { // everything changed: the delta would save nothing
+            for (size_t i=8;i<frame.size();i++)
+                frame[i]=char(frame[i]^0x55);
+            keyframeExpected=true;
+        }
+        else if (pass==30)
+        { // same pixels, other resolution
+            ((int*)&frame[0])[0]=96;
+            ((int*)&frame[0])[1]=128;
+            keyframeExpected=true;
+        }
+        else if (pass==40)
+        {
+            _setImageResolution(frame,64,48);
+            keyframeExpected=true;
+        }
+        else if (pass==50)
+        {
+            timeOffset=SIMX_DELTA_KEYFRAME_INTERVAL;
+            keyframeExpected=true;
+        }
+        else if (pass==55)
+            error=true;
+        else
+        { // a few pixels changed
+            for (int i=rand()%5;i>=0;i--)
+                frame[8+rand()%(frame.size()-8)]++;
+            keyframeExpected=(pass==56); // the first frame after an error
+        }
+        CSimxCmd* retCmd=cmd.copyYourIdentity();
+        if (error)
+            retCmd->setDataReply_nothing(false);
+        else
+            retCmd->setDataReply_custom_copyBuffer(&frame[0],int(frame.size()),true);
+        if (!cmd.encode(retCmd,pass*10+timeOffset,status,pureData))
+        {
+            ok=false;
+            continue;
+        }
+        if (error)
+        {
+            ok=ok&&((status&1)!=0)&&((status&SIMX_CMDSTATUS_DELTA)==0);
+            continue;
+        }
+        bool keyframe=((status&SIMX_CMDSTATUS_DELTA)==0);
+        ok=ok&&(keyframe==keyframeExpected)&&_applyImageReply(clientFrame,status,pureData)&&(clientFrame==frame);
+        if (pass==20)
+            ok=ok&&(pureData.size()==16);
+        if (!keyframe)
+        {
+            deltas++;
+            deltaBytes+=double(pureData.size());
+            frameBytes+=double(frame.size());
+        }
+    }
+    printf("    %-40s %8.1f %%\n","delta reply size, of the frame size",100.0*deltaBytes/frameBytes);
+    if (!ok)
+        printf("    delta replies don't rebuild the frames, or wrong keyframes!\n");
+    return(ok&&(deltas>0));
+}
+
+static bool _checkDeltaEncodedDepthU16()
+{ // the u16 depth buffer has the clipping planes after the resolution: they are compared as part of tile 0
+    CBenchStreamCmd cmd(simx_cmd_get_vision_sensor_depth_buffer_u16,42);
+    cmd.setDeltaEncoding(true);
+    std::vector<char> frame(16+64*48*2);
+    ((int*)&frame[0])[0]=64;
+    ((int*)&frame[0])[1]=48;
+    ((float*)&frame[0])[2]=0.01f;
+    ((float*)&frame[0])[3]=10.0f;
+    for (int i=0;i<64*48;i++)
+        ((WORD*)&frame[16])[i]=WORD(i*13);
+    std::vector<char> clientFrame;
+    std::vector<char> pureData;
+    BYTE status;
+    bool ok=true;
+    for (int pass=0;pass<3;pass++)
+    {
+        if (pass==1)
+            ((float*)&frame[0])[3]=20.0f; // far clipping plane
+        if (pass==2)
+            frame[frame.size()-1]++; // last pixel
+        CSimxCmd* retCmd=cmd.copyYourIdentity();
+        retCmd->setDataReply_custom_copyBuffer(&frame[0],int(frame.size()),true);
+        ok=ok&&cmd.encode(retCmd,pass*10,status,pureData)&&(((status&SIMX_CMDSTATUS_DELTA)==0)==(pass==0));
+        ok=ok&&_applyImageReply(clientFrame,status,pureData)&&(clientFrame==frame);
+        if (pass==1)
+            ok=ok&&(((int*)&pureData[8])[1]==1)&&(((int*)&pureData[16])[0]==0); // only tile 0
+    }
+    if (!ok)
+        printf("    u16 depth buffer deltas don't rebuild the frames!\n");
+    return(ok);
+}
+
+static bool _checkCompressedReplies()
+{ // large compressible replies are sent compressed, and decode to the reply. Other replies are sent as they are
+    CBenchStreamCmd cmd(simx_cmd_get_vision_sensor_depth_buffer,42);
+    cmd.setCompression(true);
+    srand(1);
+    BYTE status;
+    std::vector<char> pureData;
+    std::vector<char> decoded;
+    bool ok=true;
+    int sizes[3]={8+64*64*4,8+64*64*4,SIMX_COMPRESSION_MIN_SIZE-1};
+    for (int i=0;i<3;i++)
+    {
+        std::vector<char> reply(sizes[i]);
+        for (int j=0;j<sizes[i];j++)
+            reply[j]=((i==1)?char(rand()):char((j/512)&0x0f)); // the second one is incompressible
+        CSimxCmd* retCmd=cmd.copyYourIdentity();
+        retCmd->setDataReply_custom_copyBuffer(&reply[0],sizes[i],true);
+        ok=ok&&cmd.encode(retCmd,i*10,status,pureData);
+        bool compressedExpected=(i==0);
+        if ((status&SIMX_CMDSTATUS_COMPRESSED)!=0)
+        {
+            int size=((int*)&pureData[0])[0];
+            decoded.assign(size,0);
+            ok=ok&&compressedExpected&&(size==sizes[i])&&(pureData.size()<reply.size())&&(benchLz4Decompress(&pureData[4],int(pureData.size())-4,&decoded[0],size)==size)&&(decoded==reply);
+        }
+        else
+            ok=ok&&(!compressedExpected)&&(pureData==reply);
+    }
+    if (!ok)
+        printf("    compressed replies don't decode to the reply!\n");
+    return(ok);
+}
+
+bool benchStreamedReplies()
+{
+    printf("Streamed reply encoding:\n");
+    bool ok=_checkSendOnlyOnChange();
+    ok=_checkDeltaEncoding()&&ok;
+    ok=_checkDeltaEncodedDepthU16()&&ok;
+    ok=_checkCompressedReplies()&&ok;
+    return(ok);
+}
@@ -0,0 +1,53 @@
+#include "simxBench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <chrono>
+
+static volatile long _allocationCnt=0;
+
+void* operator new(size_t size)
+{ // counted, to check that the steady paths don't allocate
+    _allocationCnt++;
+    void* p=malloc(size>0?size:1);
+    if (p==NULL)
+        throw std::bad_alloc();
+    return(p);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+long getBenchAllocationCount()
+{
+    return(_allocationCnt);
+}
+
+double getBenchTime()
+{
+    return(std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void printBenchThroughput(const char* what,double bytes,double seconds)
+{
+    printf("    %-40s %8.1f MB/s\n",what,bytes/(seconds*1000000.0));
+}
+
+int main(int argc,char* argv[])
+{
+    bool ok=true;
+    ok=benchReplyBuilding()&&ok;
+    ok=benchContainerRemoval()&&ok;
+    ok=benchPartialCommands()&&ok;
+    ok=benchImageKernels()&&ok;
+    ok=benchStreamedReplies()&&ok;
+    ok=benchCompression()&&ok;
+    if (!ok)
+    {
+        printf("FAILED\n");
+        return(1);
+    }
+    return(0);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "porting.h"
+
+// Standalone benchmarks of the plugin's hot paths. They do not need V-REP: only code that doesn't call the V-REP API is run.
+// Each benchmark prints its results and returns false if one of its checks failed
+
+double getBenchTime(); // in seconds
+long getBenchAllocationCount(); // heap allocations so far
+void printBenchThroughput(const char* what,double bytes,double seconds);
+int benchLz4Decompress(const char* source,int sourceSize,char* dest,int destSize); // reference decoder for lz4Compress
+
+bool benchReplyBuilding();
+bool benchContainerRemoval();
+bool benchPartialCommands();
+bool benchImageKernels();
+bool benchStreamedReplies();
+bool benchCompression();
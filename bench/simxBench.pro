@@ -0,0 +1,96 @@
+QT -= core
+QT -= gui
+
+TARGET = simxBench
+TEMPLATE = app
+
+DEFINES -= UNICODE
+DEFINES += QT_COMPIL
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++11
+INCLUDEPATH += ".."
+INCLUDEPATH += "../../include"
+
+*-msvc* {
+    QMAKE_CXXFLAGS += -O2
+    QMAKE_CXXFLAGS += -W3
+}
+*-g++* {
+    QMAKE_CXXFLAGS += -O3
+    QMAKE_CXXFLAGS += -Wall
+    QMAKE_CXXFLAGS += -Wno-unused-parameter
+    QMAKE_CXXFLAGS += -Wno-strict-aliasing
+    QMAKE_CXXFLAGS += -Wno-empty-body
+    QMAKE_CXXFLAGS += -Wno-write-strings
+
+    QMAKE_CXXFLAGS += -Wno-unused-but-set-variable
+    QMAKE_CXXFLAGS += -Wno-unused-local-typedefs
+    QMAKE_CXXFLAGS += -Wno-narrowing
+
+    QMAKE_CFLAGS += -O3
+    QMAKE_CFLAGS += -Wall
+    QMAKE_CFLAGS += -Wno-strict-aliasing
+    QMAKE_CFLAGS += -Wno-unused-parameter
+    QMAKE_CFLAGS += -Wno-unused-but-set-variable
+    QMAKE_CFLAGS += -Wno-unused-local-typedefs
+}
+
+
+win32 {
+    DEFINES += WIN_VREP
+    LIBS += -lwinmm
+    LIBS += -lWs2_32
+    LIBS += -lKernel32
+}
+
+macx {
+    DEFINES += MAC_VREP
+}
+
+unix:!macx {
+    DEFINES += LIN_VREP
+    LIBS += -lrt
+    LIBS += -ldl
+    LIBS += -lpthread
+}
+
+# The plugin sources, without the plugin entry points. The V-REP library is never loaded
+SOURCES += \
+    main.cpp \
+    benchReply.cpp \
+    benchContainer.cpp \
+    benchImage.cpp \
+    benchStream.cpp \
+    benchCompression.cpp \
+    ../confReader.cpp \
+    ../inConnection.cpp \
+    ../porting.cpp \
+    ../simxCmd.cpp \
+    ../simxConnections.cpp \
+    ../simxReactor.cpp \
+    ../simxContainer.cpp \
+    ../simxImage.cpp \
+    ../simxSocket.cpp \
+    ../simxUtils.cpp \
+    ../../common/scriptFunctionData.cpp \
+    ../../common/scriptFunctionDataItem.cpp \
+    ../../common/shared_memory.c \
+    ../../common/v_repLib.cpp \
+
+HEADERS +=\
+    simxBench.h \
+    ../confReader.h \
+    ../inConnection.h \
+    ../porting.h \
+    ../simxCmd.h \
+    ../simxConnections.h \
+    ../simxReactor.h \
+    ../simxContainer.h \
+    ../simxImage.h \
+    ../simxSocket.h \
+    ../simxUtils.h \
+    ../../include/scriptFunctionData.h \
+    ../../include/scriptFunctionDataItem.h \
+    ../../include/shared_memory.h \
+    ../../include/v_repLib.h \
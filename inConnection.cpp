@@ -1,6 +1,11 @@
 #include "inConnection.h"
 #include "simxUtils.h"
 #define HEADER_LENGTH 6 // WORD0=1 (to detect endianness), WORD1=packetSize, WORD2=packetsLeftToRead
+#define LARGE_FRAME_MARKER 3
+#define LARGE_FRAME_HEADER_LENGTH 10 // WORD0=3 (to detect endianness and this framing), int packetSize, int packetsLeftToRead
+#define LARGE_FRAME_MAX_SIZE (256*1024*1024)
+#define MAX_MESSAGE_SIZE (256*1024*1024) // all packets of a message together. A client sending more is disconnected
+#define RECEIVE_CHUNK_SIZE 16384 // event loop mode: we read at most that much per recv call
 #define SOCKET_TIMEOUT_READ 10000 // in ms
 #define TCP_SEVER_CONNECT_TIMEOUT_USEC (5000*1000)
 
@@ -9,15 +14,96 @@
 #include <sys/stat.h>   /* Defines mode constants */
 #include <sys/mman.h>
 #include <stdio.h>
+#include <errno.h>
 #endif
+#if defined (__linux) || defined (__APPLE__)
+#include <sys/uio.h>
+#include <limits.h>
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+#endif
+#if defined (__linux)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#endif
+#if defined (__i386__) || defined (__x86_64__)
+#include <emmintrin.h>
+#endif
+#define SHAREDMEM_SPIN_MIN 64
+#define SHAREDMEM_SPIN_MAX 4096
+#define SHAREDMEM_SLEEP_MAX_USEC 1000 // clients that don't wake us up are still polled at least every ms
+// No client in this tree calls FUTEX_WAKE, so in practice the server sleeps in timed waits, backing off from 50us to 1ms,
+// rather than waking up within microseconds. The waiter words below let a client that does wake us skip the wait entirely
+
+// Shared memory layout: [0]=connected, [1-4]=maxPacketSize, [5]=mailbox state, [6-17]=mailbox chunk info, [20+]=mailbox data.
+// Bytes 18 and 19 select the protocol: the server writes the highest protocol it supports to [18]. A client that wants the
+// ring protocol writes SHAREDMEM_PROTOCOL_RING to [19] before setting [0] to 1. Old clients leave [19] at 0 and keep using the mailbox.
+// With the ring protocol, the mailbox area is replaced by 2 single producer/single consumer rings (requests and replies), so that
+// the client can queue its next request while the server is still writing the previous reply:
+// [20-35]=request ring data offset and size, reply ring data offset and size (ints, sizes are powers of 2)
+// [36-39]=server waiter word, [40-43]=client waiter word: a side sets its word before FUTEX_WAIT and clears it after. The other side only calls FUTEX_WAKE when it is set.
+// the head and tail counters (unsigned ints, monotonically increasing byte counts) are on separate cache lines, at the offsets below.
+// A ring holds 8-byte aligned records: int chunkLength, int totalLength, then the chunk. Messages larger than a ring are streamed in several chunks.
+#define SHAREDMEM_PROTOCOL_MAILBOX 1
+#define SHAREDMEM_PROTOCOL_RING 2
+#define SHAREDMEM_OFFSET_SERVER_PROTOCOL 18
+#define SHAREDMEM_OFFSET_CLIENT_PROTOCOL 19
+#define SHAREDMEM_OFFSET_RING_LAYOUT 20
+#define SHAREDMEM_OFFSET_SERVER_WAITING 36
+#define SHAREDMEM_OFFSET_CLIENT_WAITING 40
+#define SHAREDMEM_OFFSET_REQUEST_HEAD 64
+#define SHAREDMEM_OFFSET_REQUEST_TAIL 128
+#define SHAREDMEM_OFFSET_REPLY_HEAD 192
+#define SHAREDMEM_OFFSET_REPLY_TAIL 256
+#define SHAREDMEM_OFFSET_RING_DATA 320
+#define SHAREDMEM_RING_MIN_SIZE 64
+
+static inline void _cpuRelax()
+{
+#if defined (__i386__) || defined (__x86_64__)
+    _mm_pause();
+#elif defined (_WIN32)
+    YieldProcessor();
+#endif
+}
+
+static inline void _memoryBarrier()
+{
+#if defined (_WIN32)
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+static inline volatile int* _futexWord(volatile char* b)
+{ // the 4-byte aligned word that contains the byte
+    return((volatile int*)(((size_t)b)&(~size_t(3))));
+}
+
 CInConnection::CInConnection(int theConnectionPort,int maxPacketSize,bool newVersion)
 {
     _newVersion=newVersion;
     _otherSideIsBigEndian=false;
+    _largeFrames=false;
+    _receivedMessageComplete=false;
+    _packetDataLeft=0;
+    _packetIsLast=false;
+    _nonBlockingReplies=false;
+    _unsentReplyOffset=0;
     _connected=false;
     _leaveConnectionWait=false;
     _maxPacketSize=maxPacketSize;
     _usingSharedMem=(theConnectionPort<0);
+    _sharedMemSpinCount=SHAREDMEM_SPIN_MAX;
+    _sharedMemRingMode=false;
+    _lastReplySyscallCount=0;
+    _socketOptions.noDelay=false;
+    _socketOptions.quickAck=false;
+    _socketOptions.rcvBuf=0;
+    _socketOptions.sndBuf=0;
     if (_usingSharedMem)
     { // shared memory routines are courtesy of Benjamin Navarro
 		theConnectionPort=-theConnectionPort;
@@ -31,6 +117,7 @@ CInConnection::CInConnection(int theConnectionPort,int maxPacketSize,bool newVer
 			{
 				_shared_memory_info.buffer[0] = 0; // not yet connected
 				((int*)(_shared_memory_info.buffer+1))[0] = _maxPacketSize;
+				_initSharedMemRings();
 			}
 			else
 			{
@@ -97,7 +184,11 @@ CInConnection::~CInConnection()
 
             #if defined (__linux) || defined (__APPLE__)
                 if (_local_socket !=-1)
+                {
                     close(_local_socket);
+                    if (_unixSocketPath.length()!=0)
+                        _removeUnixSocketFile();
+                }
                 if (_accepted_socket !=-1)
                     close(_accepted_socket);
             #endif /* __linux || __APPLE__ */
@@ -115,6 +206,8 @@ CInConnection::~CInConnection()
                     if (_socketServer!=-1)
                     {
                         close(_socketServer);
+                        if (_unixSocketPath.length()!=0)
+                            _removeUnixSocketFile();
                     }
                     if (_socketClient!=-1)
                     {
@@ -137,14 +230,14 @@ bool CInConnection::connectToClient()
 		{
 			while (!_leaveConnectionWait)
 			{
-				bool connected = _shared_memory_info.buffer[0] == 1;
+				bool connected = _waitForSharedMem(0,1,false,100); // returns regularly, so that we can check _leaveConnectionWait
 
 				if(connected)
 				{
 					break;
 				}
-				Sleep(1);
 			}
+			_sharedMemRingMode=( (_shared_memory_info.buffer[SHAREDMEM_OFFSET_SERVER_PROTOCOL]==SHAREDMEM_PROTOCOL_RING)&&(_shared_memory_info.buffer[SHAREDMEM_OFFSET_CLIENT_PROTOCOL]==SHAREDMEM_PROTOCOL_RING) );
 			_connected = true;
 			return true;
 		}
@@ -165,16 +258,10 @@ bool CInConnection::connectToClient()
                         return(false);
                 #endif
 
-                _local_socket = socket(AF_INET, SOCK_STREAM, 0);
+                _local_socket = _createListeningSocket();
                 if (_local_socket == INVALID_SOCKET)
                     return(false);
 
-                if (bind(_local_socket, (struct sockaddr*)&_address, sizeof(_address))!= 0)
-                    return(false);
-
-                if (listen(_local_socket, 10)!= 0)
-                    return(false);
-
                 FD_ZERO(&_read_fd);
                 FD_SET(_local_socket, &_read_fd);
                 _listening = true;
@@ -198,35 +285,10 @@ bool CInConnection::connectToClient()
                     return (false);
 
                 // 2. accept client:
-                struct sockaddr_in from;
-                int fromlen=sizeof(from);
-
-                _accepted_socket = accept(_local_socket,(struct sockaddr*) &from, (_socklen *) &fromlen);
-                _socketConnectedMachineIP = inet_ntoa(from.sin_addr);
+                _accepted_socket = _acceptClient(_local_socket,_socketConnectedMachineIP);
                 _socketTimeOut.tv_sec = 1; // 1 second max between successive receive for the same packet
                 _socketTimeOut.tv_usec = 0;
-
-                // Following since 13/12/2013:
-                #ifdef _WIN32
-                    int to = 2000;
-                    setsockopt(_accepted_socket, SOL_SOCKET, SO_RCVTIMEO,(char*)&to,sizeof(int));
-                    setsockopt(_accepted_socket, SOL_SOCKET, SO_SNDTIMEO,(char*)&to,sizeof(int));
-                    int yes = 1;
-                    setsockopt(_accepted_socket, SOL_SOCKET, SO_REUSEADDR,(char*)&yes, sizeof(int));
-
-//                  to = 3000000;
-//                  setsockopt(_accepted_socket, SOL_SOCKET, SO_RCVBUF,(char*)&to,sizeof(int));
-//                  setsockopt(_accepted_socket, SOL_SOCKET, SO_SNDBUF,(char*)&to,sizeof(int));
-
-                #else
-                    struct timeval tv;
-                    tv.tv_sec = 2; // from 0 to 2 on 28/6/2014. Thanks to Ulrich Schwesinger for catching this
-                    tv.tv_usec = 2000;
-                    setsockopt(_accepted_socket, SOL_SOCKET, SO_RCVTIMEO,(struct timeval *)&tv,sizeof(struct timeval));
-                    setsockopt(_accepted_socket, SOL_SOCKET, SO_SNDTIMEO,(struct timeval *)&tv,sizeof(struct timeval));
-                    int yes = 1;
-                    setsockopt(_accepted_socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
-                #endif
+                _configureClientSocket(_accepted_socket);
 
                 _connected = true;
                 return(true);
@@ -241,45 +303,38 @@ bool CInConnection::connectToClient()
                     return(false);   // WSAStartup failed.
             #endif /* _WIN32 */
 
-            _socketLocal.sin_family=AF_INET;
-            _socketLocal.sin_addr.s_addr=INADDR_ANY;
-            _socketLocal.sin_port=htons((u_short)_socketConnectionPort);
-            _socketServer=socket(AF_INET,SOCK_STREAM,0);
-            if (_socketServer==INVALID_SOCKET)
-                return(false); // socket failed.
+#if defined (__linux) || defined (__APPLE__)
+            if (_unixSocketPath.length()!=0)
+            {
+                _socketServer=_createListeningSocket();
+                if (_socketServer==INVALID_SOCKET)
+                    return(false); // socket, bind or listen failed.
+            }
+            else
+#endif /* __linux || __APPLE__ */
+            {
+                _socketLocal.sin_family=AF_INET;
+                _socketLocal.sin_addr.s_addr=INADDR_ANY;
+                _socketLocal.sin_port=htons((u_short)_socketConnectionPort);
+                _socketServer=socket(AF_INET,SOCK_STREAM,0);
+                if (_socketServer==INVALID_SOCKET)
+                    return(false); // socket failed.
+                _setSocketBufferSizes(_socketServer);
 
-            if (bind(_socketServer,(struct sockaddr*)&_socketLocal,sizeof(_socketLocal))!=0)
-                return(false); // bind failed.
+                if (bind(_socketServer,(struct sockaddr*)&_socketLocal,sizeof(_socketLocal))!=0)
+                    return(false); // bind failed.
 
-            if (listen(_socketServer,10)!=0)
-                return(false); // listen failed.
+                if (listen(_socketServer,10)!=0)
+                    return(false); // listen failed.
+            }
 
             // 2. accept client:
-            struct sockaddr_in from;
-            int fromlen=sizeof(from);
-            _socketClient=accept(_socketServer,(struct sockaddr*) &from, (_socklen *) &fromlen);
-            _socketConnectedMachineIP=inet_ntoa(from.sin_addr);
+            _socketClient=_acceptClient(_socketServer,_socketConnectedMachineIP);
             _socketTimeOut.tv_sec=1; // 1 second max between successive receive for the same packet
             _socketTimeOut.tv_usec=0;
             FD_ZERO(&_socketTheSet);
             FD_SET(_socketClient,&_socketTheSet);
-
-            // Following since 13/12/2013:
-            #ifdef _WIN32
-                int to=2000;
-                setsockopt(_socketClient, SOL_SOCKET, SO_RCVTIMEO,(char*)&to,sizeof(int));
-                setsockopt(_socketClient, SOL_SOCKET, SO_SNDTIMEO,(char*)&to,sizeof(int));
-                int yes = 1;
-                setsockopt(_socketClient, SOL_SOCKET, SO_REUSEADDR,(char*)&yes, sizeof(int));
-            #else
-                struct timeval tv;
-                tv.tv_sec = 2; // from 0 to 2 on 28/6/2014. Thanks to Ulrich Schwesinger for catching this
-                tv.tv_usec = 2000;
-                setsockopt(_socketClient, SOL_SOCKET, SO_RCVTIMEO,(struct timeval *)&tv,sizeof(struct timeval));
-                setsockopt(_socketClient, SOL_SOCKET, SO_SNDTIMEO,(struct timeval *)&tv,sizeof(struct timeval));
-                int yes = 1;
-                setsockopt(_socketClient, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
-            #endif
+            _configureClientSocket(_socketClient);
 
             _connected=true;
             return(true);
@@ -287,6 +342,127 @@ bool CInConnection::connectToClient()
     }
 }
 
+_SOCKET CInConnection::_createListeningSocket()
+{ // new version and event loop mode (and old version with a Unix domain socket)
+#if defined (__linux) || defined (__APPLE__)
+    if (_unixSocketPath.length()!=0)
+    {
+        struct sockaddr_un addr;
+        memset(&addr,0,sizeof(addr));
+        addr.sun_family=AF_UNIX;
+        if (_unixSocketPath.length()>=sizeof(addr.sun_path))
+            return(INVALID_SOCKET); // path too long
+        strcpy(addr.sun_path,_unixSocketPath.c_str());
+        _removeUnixSocketFile(); // a socket file left by a previous run would make bind fail
+        _SOCKET s=socket(AF_UNIX,SOCK_STREAM,0);
+        if (s==INVALID_SOCKET)
+            return(INVALID_SOCKET);
+        _setSocketBufferSizes(s);
+        if ( (bind(s,(struct sockaddr*)&addr,sizeof(addr))!=0)||(listen(s,10)!=0) )
+        {
+            close(s);
+            return(INVALID_SOCKET);
+        }
+        return(s);
+    }
+#endif /* __linux || __APPLE__ */
+    _SOCKET s=socket(AF_INET,SOCK_STREAM,0);
+    if (s==INVALID_SOCKET)
+        return(INVALID_SOCKET);
+    _setSocketBufferSizes(s);
+    if ( (bind(s,(struct sockaddr*)&_address,sizeof(_address))!=0)||(listen(s,10)!=0) )
+    {
+        #ifdef _WIN32
+            closesocket(s);
+        #else
+            close(s);
+        #endif
+        return(INVALID_SOCKET);
+    }
+    return(s);
+}
+
+_SOCKET CInConnection::_acceptClient(_SOCKET listeningSocket,std::string& clientIP)
+{
+#if defined (__linux) || defined (__APPLE__)
+    if (_unixSocketPath.length()!=0)
+    {
+        clientIP="local ("+_unixSocketPath+")";
+        return(accept(listeningSocket,NULL,NULL));
+    }
+#endif /* __linux || __APPLE__ */
+    struct sockaddr_in from;
+    _socklen fromlen=sizeof(from);
+    _SOCKET s=accept(listeningSocket,(struct sockaddr*)&from,&fromlen);
+    clientIP=inet_ntoa(from.sin_addr);
+    return(s);
+}
+
+#if defined (__linux) || defined (__APPLE__)
+void CInConnection::setUnixSocketPath(const char* path)
+{ // call before connectToClient/startListening. The port number then only identifies this connection
+    _unixSocketPath=path;
+}
+
+void CInConnection::_removeUnixSocketFile()
+{ // only if it is a socket: we don't want to delete a regular file because of a typo in the path
+    struct stat st;
+    if ( (lstat(_unixSocketPath.c_str(),&st)==0)&&S_ISSOCK(st.st_mode) )
+        unlink(_unixSocketPath.c_str());
+}
+#endif /* __linux || __APPLE__ */
+
+void CInConnection::_configureClientSocket(_SOCKET s)
+{
+    // Following since 13/12/2013:
+    #ifdef _WIN32
+        int to=2000;
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO,(char*)&to,sizeof(int));
+        setsockopt(s, SOL_SOCKET, SO_SNDTIMEO,(char*)&to,sizeof(int));
+        int yes = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR,(char*)&yes, sizeof(int));
+    #else
+        struct timeval tv;
+        tv.tv_sec = 2; // from 0 to 2 on 28/6/2014. Thanks to Ulrich Schwesinger for catching this
+        tv.tv_usec = 2000;
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO,(struct timeval *)&tv,sizeof(struct timeval));
+        setsockopt(s, SOL_SOCKET, SO_SNDTIMEO,(struct timeval *)&tv,sizeof(struct timeval));
+        int yes = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+    #endif
+    _setSocketBufferSizes(s);
+    if (_unixSocketPath.length()==0)
+    { // TCP only
+        if (_socketOptions.noDelay)
+            setsockopt(s, IPPROTO_TCP, TCP_NODELAY,(char*)&yes, sizeof(int));
+        _rearmQuickAck(s);
+    }
+}
+
+void CInConnection::_setSocketBufferSizes(_SOCKET s)
+{ // also called for the listening socket: the TCP window scaling is negotiated during the handshake, before we can set the client socket's options
+    if (_socketOptions.rcvBuf>0)
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF,(char*)&_socketOptions.rcvBuf,sizeof(int));
+    if (_socketOptions.sndBuf>0)
+        setsockopt(s, SOL_SOCKET, SO_SNDBUF,(char*)&_socketOptions.sndBuf,sizeof(int));
+}
+
+void CInConnection::_rearmQuickAck(_SOCKET s)
+{ // Linux clears TCP_QUICKACK again after a while, so we set it after each received packet
+#if defined (__linux)
+    if ( (_socketOptions.quickAck)&&(_unixSocketPath.length()==0) )
+    {
+        int yes=1;
+        setsockopt(s, IPPROTO_TCP, TCP_QUICKACK, &yes, sizeof(int));
+    }
+#endif /* __linux */
+}
+
+void CInConnection::setSocketOptions(const SSocketOptions& options)
+{ // call before connectToClient/startListening
+    _socketOptions=options;
+}
+
 void CInConnection::stopWaitingForConnection()
 { // Make a fake connection to this socket, to unblock it (the thread might be trapped in the "accept" function)
     _leaveConnectionWait=true;
@@ -294,6 +470,7 @@ void CInConnection::stopWaitingForConnection()
 
 char* CInConnection::receiveMessage(int& messageSize)
 { // Returns the data size if >0, 0=we had a read time out, -1=we have an error
+  // The returned buffer belongs to this object and is reused: it is valid until the next receive call
     if (!_connected)
     {
         messageSize=-1; // error
@@ -305,29 +482,69 @@ char* CInConnection::receiveMessage(int& messageSize)
     }
     else
     {
-        std::vector<char> receivedData;
+        _receivedMessage.clear(); // keeps its capacity
         while (true)
         {
-            std::vector<char> inDat;
-            int result=_receiveSimplePacket(inDat);
+            int result=_receiveSimplePacket(_receivedMessage);
             if (result<0)
             {
                 messageSize=result+1; // error or read time-out
                 return(NULL);
             }
-            receivedData.insert(receivedData.end(),inDat.begin(),inDat.end());
             if (result==0)
             { // success
-                messageSize=int(receivedData.size());
-                char* retBuff=new char[messageSize];
-                for (int i=0;i<messageSize;i++)
-                    retBuff[i]=receivedData[i];
-                return(retBuff);
+                messageSize=int(_receivedMessage.size());
+                if (messageSize==0)
+                    return(NULL);
+                return(&_receivedMessage[0]);
             }
         }
     }
 }
 
+char* CInConnection::getReplyBuffer(int messageSize)
+{ // With shared memory, returns where a reply of that size can directly be written, if the space is free right now (i.e. the reply doesn't need to be split). Otherwise NULL
+    if ( (!_connected)||(!_usingSharedMem)||(messageSize==0) )
+        return(NULL);
+    if (_shared_memory_info.buffer[0]!=1)
+        return(NULL);
+    if (_sharedMemRingMode)
+    {
+        unsigned int h=((volatile unsigned int*)(_shared_memory_info.buffer+_replyRing.headOffset))[0];
+        unsigned int t=((volatile unsigned int*)(_shared_memory_info.buffer+_replyRing.tailOffset))[0];
+        int pos=int(h&(_replyRing.size-1));
+        if ( (8+messageSize>_replyRing.size-int(h-t))||(pos+8+messageSize>_replyRing.size) )
+            return(NULL); // not enough free space, or the record would wrap
+        _memoryBarrier(); // the client is done reading that space
+        return(_shared_memory_info.buffer+_replyRing.dataOffset+pos+8);
+    }
+    if ( (messageSize>_maxPacketSize)||(((volatile char*)_shared_memory_info.buffer)[5]!=0) )
+        return(NULL);
+    _memoryBarrier();
+    return(_shared_memory_info.buffer+20);
+}
+
+bool CInConnection::replyWithReplyBuffer(int messageSize)
+{ // The reply was written to the location returned by getReplyBuffer: we just need to publish it
+    if (_sharedMemRingMode)
+    {
+        volatile unsigned int* head=(volatile unsigned int*)(_shared_memory_info.buffer+_replyRing.headOffset);
+        unsigned int h=head[0];
+        char* record=_shared_memory_info.buffer+_replyRing.dataOffset+int(h&(_replyRing.size-1));
+        ((int*)record)[0]=messageSize;
+        ((int*)record)[1]=messageSize;
+        _memoryBarrier();
+        head[0]=h+((8+messageSize+7)&(~7));
+        _notifySharedMem(_replyRing.headOffset);
+        return(true);
+    }
+    ((int*)(_shared_memory_info.buffer+6))[0]=messageSize;
+    ((int*)(_shared_memory_info.buffer+6))[1]=20;
+    ((int*)(_shared_memory_info.buffer+6))[2]=messageSize;
+    _setSharedMemState(2);     /* server has something to send! */
+    return(true);
+}
+
 bool CInConnection::replyToReceivedMessage(char* message,int messageSize)
 {
     if (!_connected)
@@ -341,35 +558,192 @@ bool CInConnection::replyToReceivedMessage(char* message,int messageSize)
     }
     else
     {
-        // In Following we make sure we don't send too big packets (we might send the data in several packets)
-        int packetCount=0;
-        int s=messageSize;
-        while (s!=0)
+        // In Following we make sure we don't send too big packets (we might send the data in several packets). Clients using the large framing get everything in one packet
+        int headerLength=HEADER_LENGTH;
+        int payloadPerPacket=_maxPacketSize-HEADER_LENGTH;
+        if (_largeFrames)
         {
-            packetCount++;
-            if (s>_maxPacketSize-HEADER_LENGTH)
-                s-=_maxPacketSize-HEADER_LENGTH;
-            else
-                s=0;
+            headerLength=LARGE_FRAME_HEADER_LENGTH;
+            payloadPerPacket=messageSize;
         }
-
-        s=messageSize;
+        int packetCount=(messageSize+payloadPerPacket-1)/payloadPerPacket;
+        _replyHeaders.resize(packetCount*headerLength);
+#if defined (__linux) || defined (__APPLE__)
+        // All headers and payload slices go out with as few system calls as possible, without copying the payload:
+        _replySlices.resize(packetCount*2);
+#endif /* __linux || __APPLE__ */
+#ifdef _WIN32
+        // Winsock 1.1 has no gather send: we assemble the packets in one buffer, and send it in one go
+        _replyBuffer.resize(messageSize+packetCount*headerLength);
+        int bufferPtr=0;
+#endif /* _WIN32 */
         int ptr=0;
-        while (s!=0)
+        for (int i=0;i<packetCount;i++)
         {
-            packetCount--;
-            int sizeToSend=s;
-            if (s>_maxPacketSize-HEADER_LENGTH)
-                sizeToSend=_maxPacketSize-HEADER_LENGTH;
-            s-=sizeToSend;
-            if (!_sendSimplePacket(message+ptr,sizeToSend,packetCount))
-                return(false);
+            int sizeToSend=messageSize-ptr;
+            if (sizeToSend>payloadPerPacket)
+                sizeToSend=payloadPerPacket;
+            char* header=&_replyHeaders[i*headerLength];
+            _writePacketHeader(header,sizeToSend,packetCount-1-i);
+#if defined (__linux) || defined (__APPLE__)
+            _replySlices[2*i].iov_base=header;
+            _replySlices[2*i].iov_len=headerLength;
+            _replySlices[2*i+1].iov_base=message+ptr;
+            _replySlices[2*i+1].iov_len=sizeToSend;
+#endif /* __linux || __APPLE__ */
+#ifdef _WIN32
+            memcpy(&_replyBuffer[bufferPtr],header,headerLength);
+            memcpy(&_replyBuffer[bufferPtr+headerLength],message+ptr,sizeToSend);
+            bufferPtr+=headerLength+sizeToSend;
+#endif /* _WIN32 */
             ptr+=sizeToSend;
         }
+#if defined (__linux) || defined (__APPLE__)
+        return(_sendSlices(&_replySlices[0],int(_replySlices.size())));
+#endif /* __linux || __APPLE__ */
+#ifdef _WIN32
+        return(_sendBuffer(&_replyBuffer[0],int(_replyBuffer.size())));
+#endif /* _WIN32 */
     }
     return(true);
 }
 
+int CInConnection::getLastReplySyscallCount()
+{
+    return(_lastReplySyscallCount);
+}
+
+#if defined (__linux) || defined (__APPLE__)
+bool CInConnection::startListening()
+{ // Event loop mode: we only open the listening socket. Clients are accepted when the reactor signals it
+    if (_listening)
+        return(true);
+    _local_socket=_createListeningSocket();
+    if (_local_socket==INVALID_SOCKET)
+        return(false);
+    fcntl(_local_socket,F_SETFL,fcntl(_local_socket,F_GETFL,0)|O_NONBLOCK); // a client might vanish between poll and accept
+    _listening=true;
+    return(true);
+}
+
+_SOCKET CInConnection::getListeningSocket()
+{
+    return(_local_socket);
+}
+
+CInConnection* CInConnection::acceptNewClient()
+{ // The returned object only serves the accepted client (the listening socket stays with this object)
+    if (!_listening)
+        return(NULL);
+    std::string clientIP;
+    _SOCKET s=_acceptClient(_local_socket,clientIP);
+    if (s==INVALID_SOCKET)
+        return(NULL);
+    fcntl(s,F_SETFL,fcntl(s,F_GETFL,0)|O_NONBLOCK); // a slow client must not block the reactor thread: see _nonBlockingReplies
+    CInConnection* client=new CInConnection(ntohs(_address.sin_port),_maxPacketSize,true);
+    client->_unixSocketPath=_unixSocketPath; // the client object doesn't own the socket file (it has no listening socket)
+    client->_socketOptions=_socketOptions;
+    client->_accepted_socket=s;
+    client->_socketConnectedMachineIP=clientIP;
+    client->_configureClientSocket(s);
+    client->_nonBlockingReplies=true;
+    client->_connected=true;
+    return(client);
+}
+
+_SOCKET CInConnection::getClientSocket()
+{
+    return(_accepted_socket);
+}
+
+char* CInConnection::receiveMessageIfAvailable(int& messageSize)
+{ // Returns the data if a full message is there (messageSize>0), messageSize=0 if we need more data, -1=we have an error or the client left
+  // The returned buffer belongs to this object and is reused: it is valid until the next receive call
+    messageSize=-1;
+    if (!_connected)
+        return(NULL);
+    if (_receivedMessageComplete)
+    { // the previous message was handed out. Keep the capacity
+        _receivedMessage.clear();
+        _receivedMessageComplete=false;
+    }
+    while (true)
+    {
+        int extractResult=_extractReceivedMessage();
+        if (extractResult<0)
+            return(NULL); // corrupted data: we disconnect that client
+        if ( (extractResult!=0)&&(_receivedMessage.size()!=0) )
+        {
+            messageSize=int(_receivedMessage.size());
+            _receivedMessageComplete=true;
+            return(&_receivedMessage[0]);
+        }
+        // Receive directly at the end of the pending data:
+        size_t off=_pendingData.size();
+        _pendingData.resize(off+RECEIVE_CHUNK_SIZE);
+        int nb=recv(_accepted_socket,&_pendingData[off],RECEIVE_CHUNK_SIZE,MSG_DONTWAIT);
+        _pendingData.resize(off+(nb>0?nb:0));
+        if (nb==0)
+            return(NULL); // client closed the connection
+        if (nb<0)
+        {
+            if ((errno==EAGAIN)||(errno==EWOULDBLOCK)||(errno==EINTR))
+                messageSize=0; // we'll be called again once more data arrived
+            return(NULL);
+        }
+        _rearmQuickAck(_accepted_socket);
+    }
+}
+#endif /* __linux || __APPLE__ */
+
+int CInConnection::_extractReceivedMessage()
+{ // Moves the packet data from _pendingData to _receivedMessage as it arrives, so that a large message is not held twice. Returns 1 if the last packet of a message was moved, -1 if the data is corrupted or the message too large
+    size_t off=0;
+    int retVal=0;
+    while (true)
+    {
+        if (_packetDataLeft>0)
+        { // move what we have of the current packet's data
+            size_t n=_pendingData.size()-off;
+            if (n>size_t(_packetDataLeft))
+                n=size_t(_packetDataLeft);
+            if (n==0)
+                break;
+            _receivedMessage.insert(_receivedMessage.end(),_pendingData.begin()+off,_pendingData.begin()+off+n);
+            off+=n;
+            _packetDataLeft-=int(n);
+            if (_packetDataLeft>0)
+                break; // packet not yet complete
+        }
+        else
+        {
+            if (_pendingData.size()-off<HEADER_LENGTH)
+                break;
+            const char* headerAndSize=&_pendingData[off];
+            int headerLength=_getPacketHeaderLength(headerAndSize);
+            if (_pendingData.size()-off<size_t(headerLength))
+                break; // header not yet complete
+            int dataLength,packetsLeft;
+            if ( (!_readPacketHeader(headerAndSize,dataLength,packetsLeft))||(_receivedMessage.size()+size_t(dataLength)>MAX_MESSAGE_SIZE) )
+            {
+                retVal=-1;
+                break;
+            }
+            off+=headerLength;
+            _packetDataLeft=dataLength;
+            _packetIsLast=(packetsLeft==0);
+        }
+        if ( (_packetDataLeft==0)&&_packetIsLast )
+        {
+            _packetIsLast=false;
+            retVal=1;
+            break;
+        }
+    }
+    _pendingData.erase(_pendingData.begin(),_pendingData.begin()+off);
+    return(retVal);
+}
+
 std::string CInConnection::getConnectedMachineIP()
 {
     if (_usingSharedMem)
@@ -389,76 +763,125 @@ bool CInConnection::isOtherSideBigEndian()
     return(_otherSideIsBigEndian);
 }
 
-bool CInConnection::_sendSimplePacket(char* packet,int packetLength,WORD packetsLeft)
+void CInConnection::_writePacketHeader(char* header,int packetLength,int packetsLeft)
 {
-    if (packetLength==0)
-        return(false);
-
-    // Insert the header:
-    WORD s=WORD(packetLength);
-    char header[HEADER_LENGTH];
+    if (_largeFrames)
+    {
+        ((WORD*)header)[0]=LARGE_FRAME_MARKER; // Allows to detect endianness on the other side
+        ((int*)(header+2))[0]=littleEndianIntConversion(packetLength,_otherSideIsBigEndian);
+        ((int*)(header+6))[0]=littleEndianIntConversion(packetsLeft,_otherSideIsBigEndian);
+        return;
+    }
     ((WORD*)header)[0]=1; // Allows to detect endianness on the other side
-    ((WORD*)header)[1]=littleEndianShortConversion(s,_otherSideIsBigEndian);
-    ((WORD*)header)[2]=littleEndianShortConversion(packetsLeft,_otherSideIsBigEndian);
-
-    std::vector<char> toSend;
-    for (int i=0;i<HEADER_LENGTH;i++)
-        toSend.push_back(header[i]);
-    for (int i=0;i<packetLength;i++)
-        toSend.push_back(packet[i]);
-
-    // Send the packet:
-    if (_newVersion)
-        return(send(_accepted_socket,&toSend[0],packetLength+HEADER_LENGTH,0)==packetLength+HEADER_LENGTH);
-    else
-        return(send(_socketClient,&toSend[0],packetLength+HEADER_LENGTH,0)==packetLength+HEADER_LENGTH);
+    ((WORD*)header)[1]=littleEndianShortConversion(WORD(packetLength),_otherSideIsBigEndian);
+    ((WORD*)header)[2]=littleEndianShortConversion(WORD(packetsLeft),_otherSideIsBigEndian);
 }
 
-int CInConnection::_receiveSimplePacket(std::vector<char>& packet)
-{
-    if (_newVersion)
+#if defined (__linux) || defined (__APPLE__)
+bool CInConnection::_sendSlices(struct iovec* slices,int sliceCount)
+{ // Handles partial writes, and the IOV_MAX limit of a single call
+    _SOCKET s=_accepted_socket;
+    if (!_newVersion)
+        s=_socketClient;
+    _lastReplySyscallCount=0;
+    while (sliceCount>0)
     {
-        if (_connected)
+        struct msghdr msg;
+        memset(&msg,0,sizeof(msg));
+        msg.msg_iov=slices;
+        msg.msg_iovlen=sliceCount;
+        if (sliceCount>IOV_MAX)
+            msg.msg_iovlen=IOV_MAX;
+        ssize_t nb=sendmsg(s,&msg,0);
+        _lastReplySyscallCount++;
+        if (nb<0)
         {
-            //1. Read the header and packet size:
-            char headerAndSize[HEADER_LENGTH];
-            int totalReceived=0;
-            DWORD startT=getTimeInMs();
-            while(totalReceived!=HEADER_LENGTH)
-            {
-                int nb=recv(_accepted_socket,headerAndSize+totalReceived,HEADER_LENGTH-totalReceived,0);
-                if (nb<1)
-                    break;
-                totalReceived+=nb;
-                if (getTimeDiffInMs(startT)>SOCKET_TIMEOUT_READ)
-                    break;
+            if (errno==EINTR)
+                continue;
+            if ( _nonBlockingReplies&&((errno==EAGAIN)||(errno==EWOULDBLOCK)) )
+            { // the socket buffer is full: the rest is sent once the socket is writable again (see sendUnsentReply)
+                _keepUnsentSlices(slices,sliceCount);
+                return(true);
             }
-            // 2. Check if the header is consistent:
-            if (totalReceived!=HEADER_LENGTH)
-                return(-2); // Error reading
+            return(false); // error or time-out
+        }
+        if (nb==0)
+            return(false);
+        while ( (sliceCount>0)&&(size_t(nb)>=slices[0].iov_len) )
+        {
+            nb-=slices[0].iov_len;
+            slices++;
+            sliceCount--;
+        }
+        if (nb>0)
+        { // partial write of that slice
+            slices[0].iov_base=((char*)slices[0].iov_base)+nb;
+            slices[0].iov_len-=nb;
+        }
+    }
+    return(true);
+}
 
-            _otherSideIsBigEndian=(((WORD*)headerAndSize)[0]!=1);
+void CInConnection::_keepUnsentSlices(const struct iovec* slices,int sliceCount)
+{ // the slices point to buffers that are reused for the next reply (possibly of another client): we copy them
+    _unsentReply.clear(); // keeps its capacity
+    _unsentReplyOffset=0;
+    for (int i=0;i<sliceCount;i++)
+        _unsentReply.insert(_unsentReply.end(),(char*)slices[i].iov_base,((char*)slices[i].iov_base)+slices[i].iov_len);
+}
 
-            WORD dataLength=littleEndianShortConversion(((WORD*)headerAndSize)[1],_otherSideIsBigEndian);
+bool CInConnection::hasUnsentReply()
+{
+    return(_unsentReplyOffset<_unsentReply.size());
+}
 
-            // 3. Read the data with correct length:
-            packet.clear();
-            packet.resize(dataLength,0);
-            totalReceived=0;
-            startT=getTimeInMs();
-            while(totalReceived!=dataLength)
-            {
-                int nb=recv(_accepted_socket,&packet[0]+totalReceived,dataLength-totalReceived,0);
-                if (nb<1)
-                    break;
-                totalReceived+=nb;
-                if (getTimeDiffInMs(startT)>SOCKET_TIMEOUT_READ)
-                    break;
-            }
-            if (totalReceived!=dataLength)
-                return(-2); // wrong size or nothing received
-            return(int(littleEndianShortConversion(((WORD*)headerAndSize)[2],_otherSideIsBigEndian)));
+bool CInConnection::sendUnsentReply()
+{ // Event loop mode: call when the client socket is writable. Returns false on error
+    while (hasUnsentReply())
+    {
+        ssize_t nb=send(_accepted_socket,&_unsentReply[_unsentReplyOffset],_unsentReply.size()-_unsentReplyOffset,0);
+        if (nb<0)
+        {
+            if (errno==EINTR)
+                continue;
+            return((errno==EAGAIN)||(errno==EWOULDBLOCK)); // still full, or error
         }
+        if (nb==0)
+            return(false);
+        _unsentReplyOffset+=nb;
+    }
+    _unsentReply.clear();
+    _unsentReplyOffset=0;
+    return(true);
+}
+#endif /* __linux || __APPLE__ */
+
+#ifdef _WIN32
+bool CInConnection::_sendBuffer(const char* buffer,int bufferSize)
+{
+    _SOCKET s=_accepted_socket;
+    if (!_newVersion)
+        s=_socketClient;
+    _lastReplySyscallCount=0;
+    while (bufferSize>0)
+    {
+        int nb=send(s,buffer,bufferSize,0);
+        _lastReplySyscallCount++;
+        if (nb<1)
+            return(false);
+        buffer+=nb;
+        bufferSize-=nb;
+    }
+    return(true);
+}
+#endif /* _WIN32 */
+
+int CInConnection::_receiveSimplePacket(std::vector<char>& message)
+{ // Appends the packet data to message
+    if (_newVersion)
+    {
+        if (_connected)
+            return(_readPacket(_accepted_socket,message));
         return(-1);
     }
     else
@@ -473,50 +896,298 @@ int CInConnection::_receiveSimplePacket(std::vector<char>& packet)
             int selectResult=select(_socketClient+1, &_socketTheSet,NULL,NULL,&_socketTimeOut);
         #endif 
         if (selectResult==1)
+            return(_readPacket(_socketClient,message));
+        if (selectResult==0)
+            return(-1);
+        return(-2);
+    }
+}
+
+int CInConnection::_receiveBytes(_SOCKET s,char* buffer,int size)
+{ // returns the number of bytes received
+    int totalReceived=0;
+    DWORD startT=getTimeInMs();
+    while(totalReceived!=size)
+    {
+        int nb=recv(s,buffer+totalReceived,size-totalReceived,0);
+        if (nb<1)
+            break;
+        totalReceived+=nb;
+        if (getTimeDiffInMs(startT)>SOCKET_TIMEOUT_READ)
+            break;
+    }
+    return(totalReceived);
+}
+
+int CInConnection::_readPacket(_SOCKET s,std::vector<char>& message)
+{ // Appends the packet data to message. Returns the number of packets left to read, or -2 for an error
+    //1. Read the header and packet size:
+    char headerAndSize[LARGE_FRAME_HEADER_LENGTH];
+    if (_receiveBytes(s,headerAndSize,HEADER_LENGTH)!=HEADER_LENGTH)
+        return(-2); // Error reading
+    int headerLength=_getPacketHeaderLength(headerAndSize);
+    if ( (headerLength>HEADER_LENGTH)&&(_receiveBytes(s,headerAndSize+HEADER_LENGTH,headerLength-HEADER_LENGTH)!=headerLength-HEADER_LENGTH) )
+        return(-2); // Error reading
+
+    // 2. Check if the header is consistent:
+    int dataLength,packetsLeft;
+    if (!_readPacketHeader(headerAndSize,dataLength,packetsLeft))
+        return(-2);
+
+    // 3. Read the data with correct length:
+    size_t off=message.size();
+    if (off+size_t(dataLength)>MAX_MESSAGE_SIZE)
+        return(-2); // message too large
+    message.resize(off+dataLength);
+    if ( (dataLength>0)&&(_receiveBytes(s,&message[off],dataLength)!=dataLength) )
+        return(-2); // wrong size or nothing received
+    _rearmQuickAck(s);
+    return(packetsLeft);
+}
+
+int CInConnection::_getPacketHeaderLength(const char* header)
+{ // The first WORD tells us the framing the client uses, and its endianness. We reply with the same framing
+    WORD marker=((WORD*)header)[0];
+    _largeFrames=( (marker==LARGE_FRAME_MARKER)||(marker==(LARGE_FRAME_MARKER<<8)) );
+    if (_largeFrames)
+    {
+        _otherSideIsBigEndian=(marker!=LARGE_FRAME_MARKER);
+        return(LARGE_FRAME_HEADER_LENGTH);
+    }
+    _otherSideIsBigEndian=(marker!=1);
+    return(HEADER_LENGTH);
+}
+
+bool CInConnection::_readPacketHeader(const char* header,int& dataLength,int& packetsLeft)
+{ // call after _getPacketHeaderLength. Returns false if the header is not consistent
+    if (_largeFrames)
+    {
+        dataLength=littleEndianIntConversion(((int*)(header+2))[0],_otherSideIsBigEndian);
+        packetsLeft=littleEndianIntConversion(((int*)(header+6))[0],_otherSideIsBigEndian);
+        return( (dataLength>=0)&&(dataLength<=LARGE_FRAME_MAX_SIZE)&&(packetsLeft>=0) );
+    }
+    dataLength=littleEndianShortConversion(((WORD*)header)[1],_otherSideIsBigEndian);
+    packetsLeft=littleEndianShortConversion(((WORD*)header)[2],_otherSideIsBigEndian);
+    dataLength&=0xffff;
+    packetsLeft&=0xffff;
+    return(true);
+}
+
+bool CInConnection::_isSharedMemConditionMet(volatile char* b,int value,bool untilDifferent)
+{
+    if (untilDifferent)
+        return(((volatile int*)b)[0]!=value);
+    return(b[0]==char(value));
+}
+
+bool CInConnection::_waitForSharedMem(int offset,int value,bool untilDifferent,DWORD timeOutInMs)
+{ // Waits until the byte at offset has the given value (or until the int at offset differs from value): first we spin a bit (the reply usually arrives within microseconds), then we sleep on a futex
+    volatile char* b=(volatile char*)(_shared_memory_info.buffer+offset);
+    for (int i=0;i<_sharedMemSpinCount;i++)
+    {
+        if (_isSharedMemConditionMet(b,value,untilDifferent))
         {
-            //1. Read the header and packet size:
-            char headerAndSize[HEADER_LENGTH];
-            int totalReceived=0;
-            DWORD startT=getTimeInMs();
-            while(totalReceived!=HEADER_LENGTH)
-            {
-                int nb=recv(_socketClient,headerAndSize+totalReceived,HEADER_LENGTH-totalReceived,0);
-                if (nb<1)
-                    break;
-                totalReceived+=nb;
-                if (getTimeDiffInMs(startT)>SOCKET_TIMEOUT_READ)
-                    break;
-            }
-            // 2. Check if the header is consistent:
-            if (totalReceived!=HEADER_LENGTH)
-                return(-2); // Error reading
+            if (_sharedMemSpinCount<SHAREDMEM_SPIN_MAX)
+                _sharedMemSpinCount*=2; // spinning paid off
+            _memoryBarrier(); // the data written before the state byte is visible now
+            return(true);
+        }
+        _cpuRelax();
+    }
+    if (_sharedMemSpinCount>SHAREDMEM_SPIN_MIN)
+        _sharedMemSpinCount/=2;
 
-            _otherSideIsBigEndian=(((WORD*)headerAndSize)[0]!=1);
+    DWORD startT=getTimeInMs();
+    int sleepTime=50; // in us
+    while (!_isSharedMemConditionMet(b,value,untilDifferent))
+    {
+        if (getTimeDiffInMs(startT)>timeOutInMs)
+            return(false);
+#if defined (__linux)
+        // Not FUTEX_PRIVATE: the word is shared with the client process. Clients that call FUTEX_WAKE after writing wake us up right away
+        volatile int* w=_futexWord(b);
+        int expected=w[0];
+        volatile int* waiting=NULL; // the mailbox layout has no room for a waiter word
+        if (_sharedMemRingMode)
+        {
+            waiting=(volatile int*)(_shared_memory_info.buffer+SHAREDMEM_OFFSET_SERVER_WAITING);
+            waiting[0]=1;
+            _memoryBarrier(); // the client sees the word set, or we see its write below
+        }
+        if (!_isSharedMemConditionMet(b,value,untilDifferent))
+        {
+            struct timespec ts;
+            ts.tv_sec=0;
+            ts.tv_nsec=sleepTime*1000;
+            syscall(SYS_futex,(int*)w,FUTEX_WAIT,expected,&ts,NULL,0);
+        }
+        if (waiting!=NULL)
+            waiting[0]=0;
+#elif defined (_WIN32)
+        Sleep(sleepTime<SHAREDMEM_SLEEP_MAX_USEC?0:1);
+#else
+        usleep(sleepTime);
+#endif
+        if (sleepTime<SHAREDMEM_SLEEP_MAX_USEC)
+            sleepTime*=2;
+    }
+    _memoryBarrier();
+    return(true);
+}
+
+void CInConnection::_notifySharedMem(int offset)
+{ // Wakes up a client waiting on the word at offset. Only the ring protocol has a client waiter word: otherwise there is nobody to wake
+#if defined (__linux)
+    if (!_sharedMemRingMode)
+        return;
+    _memoryBarrier(); // our write is visible before we read the client's waiter word
+    if (((volatile int*)(_shared_memory_info.buffer+SHAREDMEM_OFFSET_CLIENT_WAITING))[0]==0)
+        return;
+    syscall(SYS_futex,(int*)_futexWord(_shared_memory_info.buffer+offset),FUTEX_WAKE,INT_MAX,NULL,NULL,0);
+#endif
+}
 
-            WORD dataLength=littleEndianShortConversion(((WORD*)headerAndSize)[1],_otherSideIsBigEndian);
+void CInConnection::_setSharedMemState(char state)
+{ // Writes the state byte (buffer[5]) once the data is in place
+    _memoryBarrier();
+    ((volatile char*)_shared_memory_info.buffer)[5]=state;
+}
 
-            // 3. Read the data with correct length:
-            packet.clear();
-            packet.resize(dataLength,0);
-            totalReceived=0;
-            startT=getTimeInMs();
-            while(totalReceived!=dataLength)
-            {
-                int nb=recv(_socketClient,&packet[0]+totalReceived,dataLength-totalReceived,0);
-                if (nb<1)
-                    break;
-                totalReceived+=nb;
-                if (getTimeDiffInMs(startT)>SOCKET_TIMEOUT_READ)
-                    break;
-            }
-            if (totalReceived!=dataLength)
-                return(-2); // wrong size or nothing received
-            return(int(littleEndianShortConversion(((WORD*)headerAndSize)[2],_otherSideIsBigEndian)));
+static int _largestPowerOfTwo(int v)
+{
+    int retVal=1;
+    while (retVal*2<=v)
+        retVal*=2;
+    return(retVal);
+}
+
+void CInConnection::_initSharedMemRings()
+{ // The request ring gets a quarter of the space, the reply ring (images, etc.) the rest. Without enough space, we only offer the mailbox
+    char* buff=_shared_memory_info.buffer;
+    buff[SHAREDMEM_OFFSET_SERVER_PROTOCOL]=SHAREDMEM_PROTOCOL_MAILBOX;
+    buff[SHAREDMEM_OFFSET_CLIENT_PROTOCOL]=0;
+    int available=_maxPacketSize+20-SHAREDMEM_OFFSET_RING_DATA;
+    if (available<2*SHAREDMEM_RING_MIN_SIZE)
+        return;
+    int requestSize=_largestPowerOfTwo(available/4);
+    if (requestSize<SHAREDMEM_RING_MIN_SIZE)
+        requestSize=SHAREDMEM_RING_MIN_SIZE;
+    _requestRing.headOffset=SHAREDMEM_OFFSET_REQUEST_HEAD;
+    _requestRing.tailOffset=SHAREDMEM_OFFSET_REQUEST_TAIL;
+    _requestRing.dataOffset=SHAREDMEM_OFFSET_RING_DATA;
+    _requestRing.size=requestSize;
+    _replyRing.headOffset=SHAREDMEM_OFFSET_REPLY_HEAD;
+    _replyRing.tailOffset=SHAREDMEM_OFFSET_REPLY_TAIL;
+    _replyRing.dataOffset=SHAREDMEM_OFFSET_RING_DATA+requestSize;
+    _replyRing.size=_largestPowerOfTwo(available-requestSize);
+    int* layout=(int*)(buff+SHAREDMEM_OFFSET_RING_LAYOUT);
+    layout[0]=_requestRing.dataOffset;
+    layout[1]=_requestRing.size;
+    layout[2]=_replyRing.dataOffset;
+    layout[3]=_replyRing.size;
+    ((unsigned int*)(buff+SHAREDMEM_OFFSET_REQUEST_HEAD))[0]=0;
+    ((unsigned int*)(buff+SHAREDMEM_OFFSET_REQUEST_TAIL))[0]=0;
+    ((unsigned int*)(buff+SHAREDMEM_OFFSET_REPLY_HEAD))[0]=0;
+    ((unsigned int*)(buff+SHAREDMEM_OFFSET_REPLY_TAIL))[0]=0;
+    ((int*)(buff+SHAREDMEM_OFFSET_SERVER_WAITING))[0]=0;
+    ((int*)(buff+SHAREDMEM_OFFSET_CLIENT_WAITING))[0]=0;
+    buff[SHAREDMEM_OFFSET_SERVER_PROTOCOL]=SHAREDMEM_PROTOCOL_RING;
+}
+
+bool CInConnection::_writeToSharedMemRing(const SShmRing& ring,const char* data,int dataLength)
+{ // We are the only producer of that ring: we own the head counter, the client owns the tail counter
+    volatile unsigned int* head=(volatile unsigned int*)(_shared_memory_info.buffer+ring.headOffset);
+    volatile unsigned int* tail=(volatile unsigned int*)(_shared_memory_info.buffer+ring.tailOffset);
+    char* ringData=_shared_memory_info.buffer+ring.dataOffset;
+    DWORD startT=getTimeInMs();
+    int off=0;
+    while (off<dataLength)
+    {
+        unsigned int h=head[0];
+        unsigned int t=tail[0];
+        int freeSpace=ring.size-int(h-t);
+        if (freeSpace<16)
+        { // Wait for the client to consume something:
+            DWORD elapsed=getTimeDiffInMs(startT);
+            if ( (elapsed>1000)||(!_waitForSharedMem(ring.tailOffset,int(t),true,1000-elapsed)) )
+                return(false);
+            continue;
         }
-        if (selectResult==0)
-            return(-1);
-        return(-2);
+        _memoryBarrier(); // the client is done reading the space we are about to overwrite
+        int l=dataLength-off;
+        if (l>freeSpace-8)
+            l=freeSpace-8;
+        int pos=int(h&(ring.size-1));
+        ((int*)(ringData+pos))[0]=l; // records are 8-byte aligned, the record header never wraps
+        ((int*)(ringData+pos))[1]=dataLength;
+        pos+=8;
+        int firstPart=ring.size-pos;
+        if (firstPart>=l)
+            memcpy(ringData+pos,data+off,l);
+        else
+        {
+            memcpy(ringData+pos,data+off,firstPart);
+            memcpy(ringData,data+off+firstPart,l-firstPart);
+        }
+        off+=l;
+        _memoryBarrier();
+        head[0]=h+((8+l+7)&(~7));
+        _notifySharedMem(ring.headOffset);
+    }
+    return(true);
+}
+
+char* CInConnection::_readFromSharedMemRing(const SShmRing& ring,int& dataLength)
+{ // We are the only consumer of that ring: we own the tail counter, the client owns the head counter
+    volatile unsigned int* head=(volatile unsigned int*)(_shared_memory_info.buffer+ring.headOffset);
+    volatile unsigned int* tail=(volatile unsigned int*)(_shared_memory_info.buffer+ring.tailOffset);
+    char* ringData=_shared_memory_info.buffer+ring.dataOffset;
+    char* retData=0;
+    int retDataOff=0;
+    int totalLength=-1;
+    dataLength=0;
+    DWORD startT=getTimeInMs();
+    while (retDataOff!=totalLength)
+    {
+        unsigned int t=tail[0];
+        unsigned int h=head[0];
+        if (h==t)
+        { // Wait for data:
+            DWORD elapsed=getTimeDiffInMs(startT);
+            if ( (elapsed>1000)||(!_waitForSharedMem(ring.headOffset,int(h),true,1000-elapsed)) )
+                return(0);
+            continue;
+        }
+        _memoryBarrier(); // the record the client published is visible now
+        int pos=int(t&(ring.size-1));
+        int l=((int*)(ringData+pos))[0];
+        int total=((int*)(ringData+pos))[1];
+        if (retData==0)
+        {
+            totalLength=total;
+            if (totalLength<=0)
+                return(0);
+            _receivedMessage.resize(totalLength);
+            retData=&_receivedMessage[0];
+        }
+        if ( (l<0)||(l>ring.size-8)||(total!=totalLength)||(retDataOff+l>totalLength) )
+            return(0); // corrupted record
+        pos+=8;
+        int firstPart=ring.size-pos;
+        if (firstPart>=l)
+            memcpy(retData+retDataOff,ringData+pos,l);
+        else
+        {
+            memcpy(retData+retDataOff,ringData+pos,firstPart);
+            memcpy(retData+retDataOff+firstPart,ringData,l-firstPart);
+        }
+        retDataOff+=l;
+        _memoryBarrier();
+        tail[0]=t+((8+l+7)&(~7)); // tell the client that space can be reused
+        _notifySharedMem(ring.tailOffset);
     }
+    dataLength=retDataOff;
+    return(retData);
 }
 
 // Shared memory routines are courtesy of Benjamin Navarro
@@ -528,18 +1199,16 @@ bool CInConnection::_send_sharedMem(const char* data,int dataLength)
 
 	if (_shared_memory_info.buffer[0] == 1)
 	{     // ok still connected
+		if (_sharedMemRingMode)
+			return(_writeToSharedMemRing(_replyRing,data,dataLength));
         DWORD startT=getTimeInMs();
 		int off=0;
 		while (dataLength>0)
 		{
             // Wait for previous data to be gone:
-			while (_shared_memory_info.buffer[5]!=0)
-			{
-				if (getTimeDiffInMs(startT)>1000)
-				{
-					return(false);
-				}
-			}
+			DWORD elapsed=getTimeDiffInMs(startT);
+			if ( (elapsed>1000)||(!_waitForSharedMem(5,0,false,1000-elapsed)) )
+				return(false);
             // ok, we can send the data:
 			if (dataLength<=_maxPacketSize)
 			{     // we can send the data in one shot:
@@ -558,7 +1227,7 @@ bool CInConnection::_send_sharedMem(const char* data,int dataLength)
 				dataLength-=(_maxPacketSize);
 				off+=(_maxPacketSize);
 			}
-			_shared_memory_info.buffer[5]=2;     /* server has something to send! */
+			_setSharedMemState(2);     /* server has something to send! */
 		}
         return(true);
 	}
@@ -570,31 +1239,37 @@ char* CInConnection::_receive_sharedMem(int& dataLength)
 	int retDataOff=0;
 	char* retData=0;
 	int totalLength=-1;
+	_receivedMessage.clear();
 	dataLength=0;
 	if (_shared_memory_info.buffer[0]==1)
 	{     // ok still connected
+		if (_sharedMemRingMode)
+			return(_readFromSharedMemRing(_requestRing,dataLength));
 		DWORD startT=getTimeInMs();
 		while (retDataOff!=totalLength)
 		{
 			// Wait for data:
-			while (_shared_memory_info.buffer[5]!=1)
-			{
-				if (getTimeDiffInMs(startT)>1000)
-				{
-					return(0);
-				}
-			}
+			DWORD elapsed=getTimeDiffInMs(startT);
+			if ( (elapsed>1000)||(!_waitForSharedMem(5,1,false,1000-elapsed)) )
+				return(0);
 			// ok, data is there!
 			// Read the data with correct length:
 			int l=((int*)(_shared_memory_info.buffer+6))[0];
 			int off=((int*)(_shared_memory_info.buffer+6))[1];
 			totalLength=((int*)(_shared_memory_info.buffer+6))[2];
 			if (retData==0)
-				retData=new char[totalLength];
+			{
+				if (totalLength<=0)
+					return(0);
+				_receivedMessage.resize(totalLength);
+				retData=&_receivedMessage[0];
+			}
+			if ( (l<0)||(retDataOff+l>totalLength) )
+				return(0); // corrupted chunk info
 			memcpy(retData+retDataOff,_shared_memory_info.buffer+off,l);
 			retDataOff=retDataOff+l;
 			// Tell the other side we have read that part and additional parts could be sent (if present):
-			_shared_memory_info.buffer[5]=0;
+			_setSharedMemState(0);
 		}
 
 	}
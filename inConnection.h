@@ -4,6 +4,22 @@
 #include "porting.h"
 #include "shared_memory.h"
 
+struct SSocketOptions
+{ // per port options, applied to the client sockets (buffer sizes also to the listening socket)
+    bool noDelay; // TCP_NODELAY: don't let Nagle hold back small replies
+    bool quickAck; // TCP_QUICKACK (Linux only): don't delay the ACKs, re-armed after each received packet
+    int rcvBuf; // SO_RCVBUF in bytes, 0 keeps the system default
+    int sndBuf; // SO_SNDBUF in bytes, 0 keeps the system default
+};
+
+struct SShmRing
+{ // single producer/single consumer ring in the shared memory (offsets are relative to the start of the shared memory)
+    int headOffset; // written by the producer
+    int tailOffset; // written by the consumer
+    int dataOffset;
+    int size; // power of 2
+};
+
 class CInConnection
 {
 public:
@@ -13,32 +29,91 @@ public:
     bool connectToClient();
     char* receiveMessage(int& messageSize);
     bool replyToReceivedMessage(char* message,int messageSize);
+    char* getReplyBuffer(int messageSize);
+    bool replyWithReplyBuffer(int messageSize);
+    int getLastReplySyscallCount();
 
     std::string getConnectedMachineIP();
     bool isOtherSideBigEndian();
+    void setSocketOptions(const SSocketOptions& options);
     void stopWaitingForConnection();
 
+#if defined (__linux) || defined (__APPLE__)
+    void setUnixSocketPath(const char* path);
+
+    // Event loop mode (the listening and client sockets are polled by CSimxReactor):
+    bool startListening();
+    _SOCKET getListeningSocket();
+    CInConnection* acceptNewClient();
+    _SOCKET getClientSocket();
+    char* receiveMessageIfAvailable(int& messageSize);
+    bool hasUnsentReply();
+    bool sendUnsentReply();
+#endif /* __linux || __APPLE__ */
+
 protected:
-    bool _sendSimplePacket(char* packet,int packetLength,WORD packetsLeft);
-    int _receiveSimplePacket(std::vector<char>& packet);
+    _SOCKET _createListeningSocket();
+    _SOCKET _acceptClient(_SOCKET listeningSocket,std::string& clientIP);
+#if defined (__linux) || defined (__APPLE__)
+    void _removeUnixSocketFile();
+#endif /* __linux || __APPLE__ */
+    void _configureClientSocket(_SOCKET s);
+    void _setSocketBufferSizes(_SOCKET s);
+    void _rearmQuickAck(_SOCKET s);
+    int _extractReceivedMessage();
+    void _writePacketHeader(char* header,int packetLength,int packetsLeft);
+#if defined (__linux) || defined (__APPLE__)
+    bool _sendSlices(struct iovec* slices,int sliceCount);
+    void _keepUnsentSlices(const struct iovec* slices,int sliceCount);
+#endif /* __linux || __APPLE__ */
+#ifdef _WIN32
+    bool _sendBuffer(const char* buffer,int bufferSize);
+#endif /* _WIN32 */
+    int _receiveSimplePacket(std::vector<char>& message);
+    int _receiveBytes(_SOCKET s,char* buffer,int size);
+    int _readPacket(_SOCKET s,std::vector<char>& message);
+    int _getPacketHeaderLength(const char* header);
+    bool _readPacketHeader(const char* header,int& dataLength,int& packetsLeft);
 
     bool _send_sharedMem(const char* data,int dataLength);
     char* _receive_sharedMem(int& dataLength);
+    bool _isSharedMemConditionMet(volatile char* b,int value,bool untilDifferent);
+    bool _waitForSharedMem(int offset,int value,bool untilDifferent,DWORD timeOutInMs);
+    void _notifySharedMem(int offset);
+    void _setSharedMemState(char state);
+    void _initSharedMemRings();
+    bool _writeToSharedMemRing(const SShmRing& ring,const char* data,int dataLength);
+    char* _readFromSharedMemRing(const SShmRing& ring,int& dataLength);
 
     _timeval        _socketTimeOut;
     int             _socketConnectionPort;
     std::string     _socketConnectedMachineIP;
+    std::string     _unixSocketPath; // when not empty, we listen on that Unix domain socket instead of the TCP port
+    SSocketOptions  _socketOptions;
     #ifdef _WIN32
         WSADATA         _socketWsaData;
     #endif /* _WIN32 */
 
     shared_memory_info_t _shared_memory_info;
+    int             _sharedMemSpinCount; // adapted to how fast the client usually answers
+    bool            _sharedMemRingMode;
+    SShmRing        _requestRing;
+    SShmRing        _replyRing;
     int             _maxPacketSize;
     bool            _otherSideIsBigEndian;
+    bool            _largeFrames; // the client uses the framing with 32-bit sizes
     bool            _connected;
     bool            _newVersion;
     bool            _usingSharedMem;
     bool            _leaveConnectionWait;
+    int             _lastReplySyscallCount;
+    std::vector<char> _replyHeaders;
+#if defined (__linux) || defined (__APPLE__)
+    std::vector<struct iovec> _replySlices;
+#endif /* __linux || __APPLE__ */
+#ifdef _WIN32
+    std::vector<char> _replyBuffer;
+#endif /* _WIN32 */
 
 
     // old version:
@@ -53,4 +128,15 @@ protected:
     struct sockaddr_in  _address;
     fd_set              _read_fd;
     bool                _listening;
+
+    std::vector<char>   _receivedMessage; // the returned received messages point into it
+
+    // event loop mode:
+    std::vector<char>   _pendingData;
+    bool                _receivedMessageComplete;
+    int                 _packetDataLeft; // data bytes of the current packet not yet moved to _receivedMessage
+    bool                _packetIsLast;
+    bool                _nonBlockingReplies; // replies are not waited for: what the socket can't take is kept in _unsentReply
+    std::vector<char>   _unsentReply;
+    size_t              _unsentReplyOffset; // what was already sent from _unsentReply
 };
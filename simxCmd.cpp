@@ -1,9 +1,168 @@
 #include "simxCmd.h"
 #include "simxUtils.h"
+#include "simxImage.h"
 #include "v_repLib.h"
 #include "simxSocket.h"
 #include "scriptFunctionData.h"
 #include <stdio.h>
+#if defined (__linux) || defined (__APPLE__)
+    #include <pthread.h>
+#endif /* __linux || __APPLE__ */
+
+class CSimxCmdPool
+{ // released CSimxCmd blocks, linked through their first bytes, and released pure data buffers, by size class. One pool for the process rather than one per socket: commands are created and destroyed from different threads (communication threads, CSimxReactor, main thread) and can outlive their socket
+public:
+    CSimxCmdPool()
+    {
+        _firstFree=NULL;
+        _freeCnt=0;
+        for (int i=0;i<SIMX_CMD_POOL_CLASS_CNT;i++)
+            _firstFreePureData[i]=NULL;
+        _freePureDataBytes=0;
+#ifdef _WIN32
+        InitializeCriticalSection(&_mutex);
+#endif /* _WIN32 */
+#if defined (__linux) || defined (__APPLE__)
+        pthread_mutex_init(&_mutex,NULL);
+#endif /* __linux || __APPLE__ */
+    }
+
+    void* get()
+    {
+        _lock();
+        void* p=_firstFree;
+        if (p!=NULL)
+        {
+            _firstFree=((void**)p)[0];
+            _freeCnt--;
+        }
+        _unlock();
+        if (p==NULL)
+            p=::operator new(sizeof(CSimxCmd));
+        return(p);
+    }
+
+    void release(void* p)
+    {
+        _lock();
+        if (_freeCnt<SIMX_CMD_POOL_MAX_FREE)
+        {
+            ((void**)p)[0]=_firstFree;
+            _firstFree=p;
+            _freeCnt++;
+            p=NULL;
+        }
+        _unlock();
+        if (p!=NULL)
+            ::operator delete(p);
+    }
+
+    static int getPureDataCapacity(int size)
+    { // the size class of a pure data buffer, or 0 if it is too large to be pooled
+        int capacity=2*SIMX_CMD_SMALL_PURE_DATA_SIZE;
+        for (int i=0;i<SIMX_CMD_POOL_CLASS_CNT;i++)
+        {
+            if (capacity>=size)
+                return(capacity);
+            capacity*=2;
+        }
+        return(0);
+    }
+
+    char* getPureData(int capacity)
+    {
+        int c=_getPureDataClass(capacity);
+        _lock();
+        char* p=_firstFreePureData[c];
+        if (p!=NULL)
+        {
+            _firstFreePureData[c]=((char**)p)[0];
+            _freePureDataBytes-=capacity;
+        }
+        _unlock();
+        if (p==NULL)
+            p=new char[capacity];
+        return(p);
+    }
+
+    void releasePureData(char* p,int capacity)
+    {
+        int c=_getPureDataClass(capacity);
+        _lock();
+        if (_freePureDataBytes+capacity<=SIMX_CMD_POOL_MAX_FREE_BYTES)
+        {
+            ((char**)p)[0]=_firstFreePureData[c];
+            _firstFreePureData[c]=p;
+            _freePureDataBytes+=capacity;
+            p=NULL;
+        }
+        _unlock();
+        delete[] p;
+    }
+
+protected:
+    static int _getPureDataClass(int capacity)
+    {
+        int c=0;
+        while ((2*SIMX_CMD_SMALL_PURE_DATA_SIZE<<c)<capacity)
+            c++;
+        return(c);
+    }
+
+    void _lock()
+    {
+#ifdef _WIN32
+        EnterCriticalSection(&_mutex);
+#endif /* _WIN32 */
+#if defined (__linux) || defined (__APPLE__)
+        pthread_mutex_lock(&_mutex);
+#endif /* __linux || __APPLE__ */
+    }
+
+    void _unlock()
+    {
+#ifdef _WIN32
+        LeaveCriticalSection(&_mutex);
+#endif /* _WIN32 */
+#if defined (__linux) || defined (__APPLE__)
+        pthread_mutex_unlock(&_mutex);
+#endif /* __linux || __APPLE__ */
+    }
+
+    void* _firstFree;
+    int _freeCnt;
+    char* _firstFreePureData[SIMX_CMD_POOL_CLASS_CNT]; // linked through their first bytes too
+    int _freePureDataBytes;
+#ifdef _WIN32
+    CRITICAL_SECTION _mutex;
+#endif /* _WIN32 */
+#if defined (__linux) || defined (__APPLE__)
+    pthread_mutex_t _mutex;
+#endif /* __linux || __APPLE__ */
+};
+
+static CSimxCmdPool* _getCmdPool()
+{ // created on first use and never destroyed: global objects of other files (e.g. allConnections) may still delete commands at exit
+    static CSimxCmdPool* pool=new CSimxCmdPool();
+    return(pool);
+}
+
+void* CSimxCmd::operator new(size_t size)
+{
+    if (size!=sizeof(CSimxCmd))
+        return(::operator new(size)); // derived class
+    return(_getCmdPool()->get());
+}
+
+void CSimxCmd::operator delete(void* p,size_t size)
+{
+    if (p==NULL)
+        return;
+    if (size!=sizeof(CSimxCmd))
+        ::operator delete(p);
+    else
+        _getCmdPool()->release(p);
+}
 
 CSimxCmd::CSimxCmd(int commandID,WORD delayOrSplit,int dataSize,const char* dataPointer)
 {
@@ -15,31 +174,34 @@ CSimxCmd::CSimxCmd(int commandID,WORD delayOrSplit,int dataSize,const char* data
     _dataSizeLeftToBeSent=0;
     _executionTime=0;
     _memorizedSplitCmd=NULL;
-    if ((_rawCmdID>simx_cmd4bytes_start)&&(_rawCmdID<simx_cmd8bytes_start))
-    {
-        for (int i=0;i<4;i++)
-            _cmdData[i]=dataPointer[i];
-        _pureDataSize-=4;
-    }
-    if ((_rawCmdID>simx_cmd8bytes_start)&&(_rawCmdID<simx_cmd1string_start))
-    {
-        for (int i=0;i<8;i++)
-            _cmdData[i]=dataPointer[i];
-        _pureDataSize-=8;
-    }
-    if ((_rawCmdID>simx_cmd1string_start)&&(_rawCmdID<simx_cmd4bytes2strings_start))
-    {
-        _cmdString=std::string(dataPointer);
-        _pureDataSize-=(int)strlen(dataPointer)+1; // with terminal zero
-    }
-    if ((_rawCmdID>simx_cmd4bytes2strings_start)&&(_rawCmdID<simx_cmd4bytes2strings_end))
+    _sendOnlyOnChange=false;
+    _hasLastSentReply=false;
+    _lastSentReplyStatus=0;
+    _lastSentReplyTime=0;
+    _deltaEncoding=false;
+    _lastKeyframeTime=0;
+    _compression=false;
+    switch (getCommandDataLayout(_rawCmdID))
     {
-        for (int i=0;i<4;i++)
-            _cmdData[i]=dataPointer[i];
-        _pureDataSize-=4;
-        _cmdString=std::string(dataPointer+4);
-        _cmdString2=std::string(dataPointer+4+1+_cmdString.size());
-        _pureDataSize-=int(_cmdString.size()+_cmdString2.size())+2; // with terminal zeros
+        case SIMX_CMDDATA_4BYTES:
+            memcpy(_cmdData,dataPointer,4);
+            _pureDataSize-=4;
+            break;
+        case SIMX_CMDDATA_8BYTES:
+            memcpy(_cmdData,dataPointer,8);
+            _pureDataSize-=8;
+            break;
+        case SIMX_CMDDATA_1STRING:
+            _cmdString=std::string(dataPointer);
+            _pureDataSize-=(int)strlen(dataPointer)+1; // with terminal zero
+            break;
+        case SIMX_CMDDATA_4BYTES2STRINGS:
+            memcpy(_cmdData,dataPointer,4);
+            _pureDataSize-=4;
+            _cmdString=std::string(dataPointer+4);
+            _cmdString2=std::string(dataPointer+4+1+_cmdString.size());
+            _pureDataSize-=int(_cmdString.size()+_cmdString2.size())+2; // with terminal zeros
+            break;
     }
     _opMode=commandID-_rawCmdID;
     if (_opMode==simx_opmode_continuous_split)
@@ -48,14 +210,12 @@ CSimxCmd::CSimxCmd(int commandID,WORD delayOrSplit,int dataSize,const char* data
             _processingDelayOrMaxDataSize=50;
     }
 
+    int pureDataSize=_pureDataSize;
+    _pureData=NULL;
+    _pureDataCapacity=0;
+    _setPureDataSize(pureDataSize);
     if (_pureDataSize>0)
-    {
-        _pureData=new char[_pureDataSize];
-        for (int i=0;i<_pureDataSize;i++)
-            _pureData[i]=dataPointer[dataSize-_pureDataSize+i];
-    }
-    else
-        _pureData=NULL;
+        memcpy(_pureData,dataPointer+dataSize-_pureDataSize,_pureDataSize);
 }
 
 CSimxCmd::CSimxCmd()
@@ -65,10 +225,185 @@ CSimxCmd::CSimxCmd()
 
 CSimxCmd::~CSimxCmd()
 {
-    delete[] _pureData;
+    _releasePureData();
     delete _memorizedSplitCmd;
 }
 
+char* CSimxCmd::_setPureDataSize(int size)
+{ // (re)allocates the pure data. Previous content is lost. Buffers come from the command pool, so that streamed replies
+  // (images, depth buffers, etc.) don't allocate once steady: each pass builds a new reply, and deletes the previous one
+    int capacity=0;
+    if (size>SIMX_CMD_SMALL_PURE_DATA_SIZE)
+        capacity=CSimxCmdPool::getPureDataCapacity(size);
+    if ( (_pureData==NULL)||(_pureData==_smallPureData)||(_pureDataCapacity!=capacity)||((capacity==0)&&(_pureDataSize!=size)) )
+    { // a buffer of the same size class (or a heap buffer of the same size) is kept as is
+        _releasePureData();
+        if (capacity>0)
+            _pureData=_getCmdPool()->getPureData(capacity);
+        else if (size>SIMX_CMD_SMALL_PURE_DATA_SIZE)
+            _pureData=new char[size];
+        else if (size>0)
+            _pureData=_smallPureData;
+        _pureDataCapacity=capacity;
+    }
+    _pureDataSize=size;
+    return(_pureData);
+}
+
+void CSimxCmd::_releasePureData()
+{
+    if (_pureDataCapacity>0)
+        _getCmdPool()->releasePureData(_pureData,_pureDataCapacity);
+    else if (_pureData!=_smallPureData)
+        delete[] _pureData;
+    _pureData=NULL;
+    _pureDataSize=0;
+    _pureDataCapacity=0;
+}
+
+const SSimxCmdDescriptor CSimxCmd::_descriptors[]=
+{ // command ID, handler, flags
+    {simx_cmd_get_joint_position,&CSimxCmd::_executeGetJointPosition,0},
+    {simx_cmd_get_joint_matrix,&CSimxCmd::_executeGetJointMatrix,0},
+    {simx_cmd_read_proximity_sensor,&CSimxCmd::_executeReadProximitySensor,0},
+    {simx_cmd_get_object_handle,&CSimxCmd::_executeGetObjectHandle,0},
+    {simx_cmd_get_ui_handle,&CSimxCmd::_executeGetUiHandle,0},
+    {simx_cmd_load_model,&CSimxCmd::_executeLoadModel,0},
+    {simx_cmd_load_scene,&CSimxCmd::_executeLoadScene,0},
+    {simx_cmd_set_joint_position,&CSimxCmd::_executeSetJointPosition,0},
+    {simx_cmd_set_spherical_joint_matrix,&CSimxCmd::_executeSetSphericalJointMatrix,0},
+    {simx_cmd_set_joint_target_velocity,&CSimxCmd::_executeSetJointTargetVelocity,0},
+    {simx_cmd_set_joint_target_position,&CSimxCmd::_executeSetJointTargetPosition,0},
+    {simx_cmd_start_pause_stop_simulation,&CSimxCmd::_executeStartPauseStopSimulation,0},
+    {simx_cmd_synchronous_next,&CSimxCmd::_executeSynchronousNext,0},
+    {simx_cmd_synchronous_enable,&CSimxCmd::_executeSynchronousEnable,0},
+    {simx_cmd_synchronous_disable,&CSimxCmd::_executeSynchronousDisable,0},
+    {simx_cmd_get_vision_sensor_image_bw,&CSimxCmd::_executeGetVisionSensorImage,SIMX_CMDFLAG_IMAGEREPLY},
+    {simx_cmd_get_vision_sensor_image_rgb,&CSimxCmd::_executeGetVisionSensorImage,SIMX_CMDFLAG_IMAGEREPLY},
+    {simx_cmd_set_vision_sensor_image_bw,&CSimxCmd::_executeSetVisionSensorImage,0},
+    {simx_cmd_set_vision_sensor_image_rgb,&CSimxCmd::_executeSetVisionSensorImage,0},
+    {simx_cmd_get_joint_force,&CSimxCmd::_executeGetJointForce,0},
+    {simx_cmd_set_joint_force,&CSimxCmd::_executeSetJointForce,0},
+    {simx_cmd_read_force_sensor,&CSimxCmd::_executeReadForceSensor,0},
+    {simx_cmd_break_force_sensor,&CSimxCmd::_executeBreakForceSensor,0},
+    {simx_cmd_read_vision_sensor,&CSimxCmd::_executeReadVisionSensor,0},
+    {simx_cmd_get_object_parent,&CSimxCmd::_executeGetObjectParent,0},
+    {simx_cmd_get_object_child,&CSimxCmd::_executeGetObjectChild,0},
+    {simx_cmd_transfer_file,&CSimxCmd::_executeTransferFile,0},
+    {simx_cmd_erase_file,&CSimxCmd::_executeEraseFile,0},
+    {simx_cmd_load_ui,&CSimxCmd::_executeLoadUi,0},
+    {simx_cmd_get_ui_slider,&CSimxCmd::_executeGetUiSlider,0},
+    {simx_cmd_set_ui_slider,&CSimxCmd::_executeSetUiSlider,0},
+    {simx_cmd_get_ui_event_button,&CSimxCmd::_executeGetUiEventButton,0},
+    {simx_cmd_get_ui_button_property,&CSimxCmd::_executeGetUiButtonProperty,0},
+    {simx_cmd_set_ui_button_property,&CSimxCmd::_executeSetUiButtonProperty,0},
+    {simx_cmd_add_statusbar_message,&CSimxCmd::_executeAddStatusbarMessage,0},
+    {simx_cmd_aux_console_open,&CSimxCmd::_executeAuxConsoleOpen,0},
+    {simx_cmd_create_dummy,&CSimxCmd::_executeCreateDummy,0},
+    {simx_cmd_aux_console_close,&CSimxCmd::_executeAuxConsoleClose,0},
+    {simx_cmd_aux_console_print,&CSimxCmd::_executeAuxConsolePrint,0},
+    {simx_cmd_aux_console_show,&CSimxCmd::_executeAuxConsoleShow,0},
+    {simx_cmd_get_vision_sensor_depth_buffer,&CSimxCmd::_executeGetVisionSensorDepthBuffer,SIMX_CMDFLAG_IMAGEREPLY},
+    {simx_cmd_get_object_orientation,&CSimxCmd::_executeGetObjectOrientation,0},
+    {simx_cmd_get_object_position,&CSimxCmd::_executeGetObjectPosition,0},
+    {simx_cmd_get_object_orientation2,&CSimxCmd::_executeGetObjectOrientation2,0},
+    {simx_cmd_get_object_quaternion,&CSimxCmd::_executeGetObjectQuaternion,0},
+    {simx_cmd_get_object_position2,&CSimxCmd::_executeGetObjectPosition2,0},
+    {simx_cmd_get_object_velocity,&CSimxCmd::_executeGetObjectVelocity,0},
+    {simx_cmd_set_object_orientation,&CSimxCmd::_executeSetObjectOrientation,0},
+    {simx_cmd_set_object_position,&CSimxCmd::_executeSetObjectPosition,0},
+    {simx_cmd_set_object_quaternion,&CSimxCmd::_executeSetObjectQuaternion,0},
+    {simx_cmd_set_object_parent,&CSimxCmd::_executeSetObjectParent,0},
+    {simx_cmd_set_ui_button_label,&CSimxCmd::_executeSetUiButtonLabel,0},
+    {simx_cmd_get_last_errors,&CSimxCmd::_executeGetLastErrors,0},
+    {simx_cmd_get_object_group_data,&CSimxCmd::_executeGetObjectGroupData,0},
+    {simx_cmd_call_script_function,&CSimxCmd::_executeCallScriptFunction,0},
+    {simx_cmd_get_array_parameter,&CSimxCmd::_executeGetArrayParameter,0},
+    {simx_cmd_set_array_parameter,&CSimxCmd::_executeSetArrayParameter,0},
+    {simx_cmd_get_boolean_parameter,&CSimxCmd::_executeGetBooleanParameter,0},
+    {simx_cmd_set_boolean_parameter,&CSimxCmd::_executeSetBooleanParameter,0},
+    {simx_cmd_get_integer_parameter,&CSimxCmd::_executeGetIntegerParameter,0},
+    {simx_cmd_set_integer_parameter,&CSimxCmd::_executeSetIntegerParameter,0},
+    {simx_cmd_get_floating_parameter,&CSimxCmd::_executeGetFloatingParameter,0},
+    {simx_cmd_set_floating_parameter,&CSimxCmd::_executeSetFloatingParameter,0},
+    {simx_cmd_get_string_parameter,&CSimxCmd::_executeGetStringParameter,0},
+    {simx_cmd_get_collision_handle,&CSimxCmd::_executeGetCollisionHandle,0},
+    {simx_cmd_get_distance_handle,&CSimxCmd::_executeGetDistanceHandle,0},
+    {simx_cmd_get_collection_handle,&CSimxCmd::_executeGetCollectionHandle,0},
+    {simx_cmd_read_collision,&CSimxCmd::_executeReadCollision,0},
+    {simx_cmd_read_distance,&CSimxCmd::_executeReadDistance,0},
+    {simx_cmd_remove_object,&CSimxCmd::_executeRemoveObject,0},
+    {simx_cmd_remove_model,&CSimxCmd::_executeRemoveModel,0},
+    {simx_cmd_remove_ui,&CSimxCmd::_executeRemoveUi,0},
+    {simx_cmd_close_scene,&CSimxCmd::_executeCloseScene,0},
+    {simx_cmd_get_objects,&CSimxCmd::_executeGetObjects,0},
+    {simx_cmd_display_dialog,&CSimxCmd::_executeDisplayDialog,0},
+    {simx_cmd_end_dialog,&CSimxCmd::_executeEndDialog,0},
+    {simx_cmd_get_dialog_result,&CSimxCmd::_executeGetDialogResult,0},
+    {simx_cmd_get_dialog_input,&CSimxCmd::_executeGetDialogInput,0},
+    {simx_cmd_copy_paste_objects,&CSimxCmd::_executeCopyPasteObjects,0},
+    {simx_cmd_get_object_selection,&CSimxCmd::_executeGetObjectSelection,0},
+    {simx_cmd_set_object_selection,&CSimxCmd::_executeSetObjectSelection,0},
+    {simx_cmd_clear_float_signal,&CSimxCmd::_executeClearFloatSignal,0},
+    {simx_cmd_clear_integer_signal,&CSimxCmd::_executeClearIntegerSignal,0},
+    {simx_cmd_clear_string_signal,&CSimxCmd::_executeClearStringSignal,0},
+    {simx_cmd_get_float_signal,&CSimxCmd::_executeGetFloatSignal,0},
+    {simx_cmd_get_integer_signal,&CSimxCmd::_executeGetIntegerSignal,0},
+    {simx_cmd_get_string_signal,&CSimxCmd::_executeGetStringSignal,0},
+    {simx_cmd_get_and_clear_string_signal,&CSimxCmd::_executeGetAndClearStringSignal,0},
+    {simx_cmd_read_string_stream,&CSimxCmd::_executeReadStringStream,0},
+    {simx_cmd_set_float_signal,&CSimxCmd::_executeSetFloatSignal,0},
+    {simx_cmd_set_integer_signal,&CSimxCmd::_executeSetIntegerSignal,0},
+    {simx_cmd_set_string_signal,&CSimxCmd::_executeSetStringSignal,0},
+    {simx_cmd_append_string_signal,&CSimxCmd::_executeAppendStringSignal,0},
+    {simx_cmd_get_object_float_parameter,&CSimxCmd::_executeGetObjectFloatParameter,0},
+    {simx_cmd_get_object_int_parameter,&CSimxCmd::_executeGetObjectIntParameter,0},
+    {simx_cmd_set_object_float_parameter,&CSimxCmd::_executeSetObjectFloatParameter,0},
+    {simx_cmd_set_object_int_parameter,&CSimxCmd::_executeSetObjectIntParameter,0},
+    {simx_cmd_get_model_property,&CSimxCmd::_executeGetModelProperty,0},
+    {simx_cmd_set_model_property,&CSimxCmd::_executeSetModelProperty,0},
+    {simx_cmd_get_joint_positions,&CSimxCmd::_executeGetJointPositions,0},
+    {simx_cmd_get_joint_forces,&CSimxCmd::_executeGetJointForces,0},
+    {simx_cmd_get_object_velocities,&CSimxCmd::_executeGetObjectVelocities,0},
+    {simx_cmd_get_object_poses,&CSimxCmd::_executeGetObjectPoses,0},
+    {simx_cmd_get_vision_sensor_image_rgb_roi,&CSimxCmd::_executeGetVisionSensorImageRegion,SIMX_CMDFLAG_IMAGEREPLY},
+    {simx_cmd_get_vision_sensor_image_bw_roi,&CSimxCmd::_executeGetVisionSensorImageRegion,SIMX_CMDFLAG_IMAGEREPLY},
+    {simx_cmd_get_vision_sensor_depth_buffer_roi,&CSimxCmd::_executeGetVisionSensorDepthBufferRegion,SIMX_CMDFLAG_IMAGEREPLY},
+    {simx_cmd_get_vision_sensor_depth_buffer_u16,&CSimxCmd::_executeGetVisionSensorDepthBufferU16,SIMX_CMDFLAG_IMAGEREPLY} // the clipping planes after the resolution go into tile 0
+};
+
+int CSimxCmd::getCommandDataLayout(int rawCmdID)
+{ // the protocol defines the command data layout through command ID ranges
+    if ((rawCmdID>simx_cmd4bytes_start)&&(rawCmdID<simx_cmd8bytes_start))
+        return(SIMX_CMDDATA_4BYTES);
+    if ((rawCmdID>simx_cmd8bytes_start)&&(rawCmdID<simx_cmd1string_start))
+        return(SIMX_CMDDATA_8BYTES);
+    if ((rawCmdID>simx_cmd1string_start)&&(rawCmdID<simx_cmd4bytes2strings_start))
+        return(SIMX_CMDDATA_1STRING);
+    if ((rawCmdID>simx_cmd4bytes2strings_start)&&(rawCmdID<simx_cmd4bytes2strings_end))
+        return(SIMX_CMDDATA_4BYTES2STRINGS);
+    return(SIMX_CMDDATA_NONE);
+}
+
+const SSimxCmdDescriptor* CSimxCmd::getCommandDescriptor(int rawCmdID)
+{ // O(1): the descriptor table is indexed by command ID, on first use (C++11 initializes the local static once, even with concurrent callers)
+    struct SDescriptorIndex
+    {
+        short index[SIMX_CMD_DESCRIPTOR_INDEX_SIZE];
+        SDescriptorIndex()
+        {
+            for (int i=0;i<SIMX_CMD_DESCRIPTOR_INDEX_SIZE;i++)
+                index[i]=-1;
+            for (int i=0;i<int(sizeof(_descriptors)/sizeof(_descriptors[0]));i++)
+                index[_descriptors[i].rawCmdID]=short(i);
+        }
+    };
+    static SDescriptorIndex descriptorIndex;
+    if ((rawCmdID<0)||(rawCmdID>=SIMX_CMD_DESCRIPTOR_INDEX_SIZE)||(descriptorIndex.index[rawCmdID]<0))
+        return(NULL);
+    return(&_descriptors[descriptorIndex.index[rawCmdID]]);
+}
+
 int CSimxCmd::getRawCommand()
 {
     return(_rawCmdID);
@@ -79,66 +414,119 @@ int CSimxCmd::getOperationMode()
     return(_opMode);
 }
 
+void CSimxCmd::setSendOnlyOnChange(bool s)
+{
+    _sendOnlyOnChange=s;
+}
+
+void CSimxCmd::setDeltaEncoding(bool d)
+{
+    _deltaEncoding=d;
+}
+
+void CSimxCmd::setCompression(bool c)
+{
+    _compression=c;
+}
+
 bool CSimxCmd::areCommandAndCommandDataSame(const CSimxCmd* otherCmd)
 {
     if (otherCmd->_rawCmdID!=_rawCmdID)
         return(false);
-    if ((_rawCmdID>simx_cmd4bytes_start)&&(_rawCmdID<simx_cmd8bytes_start))
+    switch (getCommandDataLayout(_rawCmdID))
     {
-        for (int i=0;i<4;i++)
-        {
-            if (_cmdData[i]!=otherCmd->_cmdData[i])
-                return(false);
-        }
-        return(true);
+        case SIMX_CMDDATA_4BYTES:
+            return(memcmp(_cmdData,otherCmd->_cmdData,4)==0);
+        case SIMX_CMDDATA_8BYTES:
+            return(memcmp(_cmdData,otherCmd->_cmdData,8)==0);
+        case SIMX_CMDDATA_1STRING:
+            return(_cmdString.compare(otherCmd->_cmdString)==0);
+        case SIMX_CMDDATA_4BYTES2STRINGS:
+            return((memcmp(_cmdData,otherCmd->_cmdData,4)==0)&&(_cmdString.compare(otherCmd->_cmdString)==0)&&(_cmdString2.compare(otherCmd->_cmdString2)==0));
     }
-    if ((_rawCmdID>simx_cmd8bytes_start)&&(_rawCmdID<simx_cmd1string_start))
+    return(true);
+}
+
+unsigned int CSimxCmd::getCommandAndCommandDataHash() const
+{ // commands for which areCommandAndCommandDataSame returns true have the same hash
+    unsigned int hash=getHash((const char*)&_rawCmdID,sizeof(_rawCmdID));
+    switch (getCommandDataLayout(_rawCmdID))
     {
-        for (int i=0;i<8;i++)
-        {
-            if (_cmdData[i]!=otherCmd->_cmdData[i])
-                return(false);
-        }
-        return(true);
+        case SIMX_CMDDATA_4BYTES:
+            hash=getHash(_cmdData,4,hash);
+            break;
+        case SIMX_CMDDATA_8BYTES:
+            hash=getHash(_cmdData,8,hash);
+            break;
+        case SIMX_CMDDATA_1STRING:
+            hash=getHash(_cmdString.c_str(),int(_cmdString.size()+1),hash);
+            break;
+        case SIMX_CMDDATA_4BYTES2STRINGS:
+            hash=getHash(_cmdData,4,hash);
+            hash=getHash(_cmdString.c_str(),int(_cmdString.size()+1),hash);
+            hash=getHash(_cmdString2.c_str(),int(_cmdString2.size()+1),hash);
+            break;
     }
-    if ((_rawCmdID>simx_cmd1string_start)&&(_rawCmdID<simx_cmd4bytes2strings_start))
+    return(hash);
+}
+
+void CSimxCmd::_getCommandDataSizes(int& commandByteDataSize,int& commandStringDataSize)
+{
+    commandByteDataSize=0;
+    commandStringDataSize=0;
+    switch (getCommandDataLayout(_rawCmdID))
     {
-        return(_cmdString.compare(otherCmd->_cmdString)==0);
+        case SIMX_CMDDATA_4BYTES:
+            commandByteDataSize=4;
+            break;
+        case SIMX_CMDDATA_8BYTES:
+            commandByteDataSize=8;
+            break;
+        case SIMX_CMDDATA_1STRING:
+            commandStringDataSize=(int)_cmdString.length()+1;
+            break;
+        case SIMX_CMDDATA_4BYTES2STRINGS:
+            commandByteDataSize=4;
+            commandStringDataSize=int(_cmdString.length()+_cmdString2.length()+2);
+            break;
     }
-    if ((_rawCmdID>simx_cmd4bytes2strings_start)&&(_rawCmdID<simx_cmd4bytes2strings_end))
+}
+
+char* CSimxCmd::_writeCommandData(char* dest,int commandByteDataSize,int commandStringDataSize)
+{ // writes the command data that follows the sub-header, and returns the position after it
+    memcpy(dest,_cmdData,commandByteDataSize);
+    dest+=commandByteDataSize;
+    if (commandStringDataSize>0)
     {
-        for (int i=0;i<4;i++)
-        {
-            if (_cmdData[i]!=otherCmd->_cmdData[i])
-                return(false);
+        memcpy(dest,_cmdString.c_str(),_cmdString.size()+1); // with terminal zero
+        dest+=_cmdString.size()+1;
+        if (commandStringDataSize>int(_cmdString.size()+1))
+        { // we have a second string
+            memcpy(dest,_cmdString2.c_str(),_cmdString2.size()+1); // with terminal zero
+            dest+=_cmdString2.size()+1;
         }
-        return((_cmdString.compare(otherCmd->_cmdString)==0)&&(_cmdString2.compare(otherCmd->_cmdString2)==0));
     }
-    return(true);
+    return(dest);
 }
 
-void CSimxCmd::appendYourData(std::vector<char>& dataString,bool otherSideIsBigEndian)
+int CSimxCmd::getYourDataSize()
 {
+    int commandByteDataSize,commandStringDataSize;
+    _getCommandDataSizes(commandByteDataSize,commandStringDataSize);
+    return(SIMX_SUBHEADER_SIZE+commandByteDataSize+commandStringDataSize+_pureDataSize);
+}
+
+char* CSimxCmd::writeYourData(char* dest,bool otherSideIsBigEndian)
+{ // dest must have room for getYourDataSize() bytes. Returns the position after the written data
     //1. Prepare the sub-header:
-    char header[SIMX_SUBHEADER_SIZE];
+    char header[SIMX_SUBHEADER_SIZE]={0}; // fields not used in replies (delay/split, last byte) are sent as zeros
     ((int*)(header+simx_cmdheaderoffset_cmd))[0]=littleEndianIntConversion(_rawCmdID+_opMode,otherSideIsBigEndian); // return also the opmode, we need to detect cont. cmds on the client side!
 
     header[simx_cmdheaderoffset_status]=_status;
 
     //2. Check the data to append:
-    int commandByteDataSize=0;
-    int commandStringDataSize=0;
-    if ((_rawCmdID>simx_cmd4bytes_start)&&(_rawCmdID<simx_cmd8bytes_start))
-        commandByteDataSize=4;
-    if ((_rawCmdID>simx_cmd8bytes_start)&&(_rawCmdID<simx_cmd1string_start))
-        commandByteDataSize=8;
-    if ((_rawCmdID>simx_cmd1string_start)&&(_rawCmdID<simx_cmd4bytes2strings_start))
-        commandStringDataSize=(int)_cmdString.length()+1;
-    if ((_rawCmdID>simx_cmd4bytes2strings_start)&&(_rawCmdID<simx_cmd4bytes2strings_end))
-    {
-        commandByteDataSize=4;
-        commandStringDataSize=int(_cmdString.length()+_cmdString2.length()+2);
-    }
+    int commandByteDataSize,commandStringDataSize;
+    _getCommandDataSizes(commandByteDataSize,commandStringDataSize);
 
     //3. We have the total length of this command:
     ((int*)(header+simx_cmdheaderoffset_mem_size))[0]=littleEndianIntConversion(SIMX_SUBHEADER_SIZE+commandByteDataSize+commandStringDataSize+_pureDataSize,otherSideIsBigEndian);
@@ -148,31 +536,63 @@ void CSimxCmd::appendYourData(std::vector<char>& dataString,bool otherSideIsBigE
     ((int*)(header+simx_cmdheaderoffset_sim_time))[0]=littleEndianIntConversion(_executionTime,otherSideIsBigEndian);
 
 
-    //4. Append the sub-header:
-    for (int i=0;i<SIMX_SUBHEADER_SIZE;i++)
-        dataString.push_back(header[i]);
-    //5. Append the command data:
-    for (int i=0;i<commandByteDataSize;i++)
-        dataString.push_back(_cmdData[i]);
-    if (commandStringDataSize>0)
-    {
-        for (size_t i=0;i<_cmdString.size();i++)
-            dataString.push_back(_cmdString[i]);
-        dataString.push_back(0); // terminal zero
-        if (commandStringDataSize>int(_cmdString.size()+1))
-        { // we have a second string
-            for (size_t i=0;i<_cmdString2.size();i++)
-                dataString.push_back(_cmdString2[i]);
-            dataString.push_back(0); // terminal zero
+    //4. Write the sub-header:
+    memcpy(dest,header,SIMX_SUBHEADER_SIZE);
+    //5. Write the command data:
+    dest=_writeCommandData(dest+SIMX_SUBHEADER_SIZE,commandByteDataSize,commandStringDataSize);
+    //6. Write the auxiliary data:
+    if (_pureDataSize>0)
+        memcpy(dest,_pureData,_pureDataSize);
+    return(dest+_pureDataSize);
+}
+
+void CSimxCmd::appendYourData(std::vector<char>& dataString,bool otherSideIsBigEndian)
+{
+    size_t off=dataString.size();
+    dataString.resize(off+getYourDataSize());
+    writeYourData(&dataString[off],otherSideIsBigEndian);
+}
+
+int CSimxCmd::_getSplitDataPart(int& pureDataOffset)
+{ // returns the size of the pure data part we send next. Doesn't modify anything
+    int pureDataPart=_pureDataSize;
+    pureDataOffset=0;
+    if (_pureDataSize>_processingDelayOrMaxDataSize)
+    { // we can't send everything at once
+        if (_processingDelayOrMaxDataSize<_dataSizeLeftToBeSent)
+        {
+            pureDataPart=_processingDelayOrMaxDataSize;
+        }
+        else
+        {
+            pureDataPart=_dataSizeLeftToBeSent;
         }
+        pureDataOffset=_pureDataSize-_dataSizeLeftToBeSent;
     }
-    //6. Append the auxiliary data:
-    for (int i=0;i<_pureDataSize;i++)
-        dataString.push_back(_pureData[i]);
+    return(pureDataPart);
 }
 
-bool CSimxCmd::appendYourMemorizedSplitData(bool calledFromContainer,std::vector<char>& dataString,bool& removeCommand,bool otherSideIsBigEndian)
-{
+int CSimxCmd::getYourMemorizedSplitDataSize(bool calledFromContainer)
+{ // returns the size that writeYourMemorizedSplitData will write, or 0 if there is nothing to send
+    if (calledFromContainer)
+    {
+        if ((_opMode!=simx_opmode_continuous_split)&&(_opMode!=simx_opmode_oneshot_split))
+            return(0);
+        if (_memorizedSplitCmd==NULL)
+            return(0); // not yet "first" processed
+        _memorizedSplitCmd->_dataSizeLeftToBeSent=_dataSizeLeftToBeSent;
+        return(_memorizedSplitCmd->getYourMemorizedSplitDataSize(false));
+    }
+
+    if (_dataSizeLeftToBeSent<=0)
+        return(0);
+    int commandByteDataSize,commandStringDataSize,pureDataOffset;
+    _getCommandDataSizes(commandByteDataSize,commandStringDataSize);
+    return(SIMX_SUBHEADER_SIZE+commandByteDataSize+commandStringDataSize+_getSplitDataPart(pureDataOffset));
+}
+
+bool CSimxCmd::writeYourMemorizedSplitData(bool calledFromContainer,char*& dest,bool& removeCommand,bool otherSideIsBigEndian)
+{ // dest must have room for getYourMemorizedSplitDataSize() bytes, and is moved past the written data
     if (calledFromContainer)
     {
         if ((_opMode!=simx_opmode_continuous_split)&&(_opMode!=simx_opmode_oneshot_split))
@@ -180,7 +600,7 @@ bool CSimxCmd::appendYourMemorizedSplitData(bool calledFromContainer,std::vector
         if (_memorizedSplitCmd==NULL)
             return(false); // not yet "first" processed
         _memorizedSplitCmd->_dataSizeLeftToBeSent=_dataSizeLeftToBeSent;
-        bool retVal=_memorizedSplitCmd->appendYourMemorizedSplitData(false,dataString,removeCommand,otherSideIsBigEndian);
+        bool retVal=_memorizedSplitCmd->writeYourMemorizedSplitData(false,dest,removeCommand,otherSideIsBigEndian);
         _dataSizeLeftToBeSent=_memorizedSplitCmd->_dataSizeLeftToBeSent;
         if (_opMode==simx_opmode_oneshot_split)
             removeCommand=(_dataSizeLeftToBeSent==0);
@@ -191,40 +611,20 @@ bool CSimxCmd::appendYourMemorizedSplitData(bool calledFromContainer,std::vector
         return(false);
 
     //1. Prepare the sub-header:
-    char header[SIMX_SUBHEADER_SIZE];
+    char header[SIMX_SUBHEADER_SIZE]={0}; // see writeYourData
     ((int*)(header+simx_cmdheaderoffset_cmd))[0]=littleEndianIntConversion(_rawCmdID+_opMode,otherSideIsBigEndian); // return also the opmode, we need to detect cont. cmds on the client side!
     header[simx_cmdheaderoffset_status]=_status;
 
     //2. Check the data to append:
-    int commandByteDataSize=0;
-    int commandStringDataSize=0;
-    if ((_rawCmdID>simx_cmd4bytes_start)&&(_rawCmdID<simx_cmd8bytes_start))
-        commandByteDataSize=4;
-    if ((_rawCmdID>simx_cmd8bytes_start)&&(_rawCmdID<simx_cmd1string_start))
-        commandByteDataSize=8;
-    if ((_rawCmdID>simx_cmd1string_start)&&(_rawCmdID<simx_cmd4bytes2strings_start))
-        commandStringDataSize=(int)_cmdString.length()+1;
-    if ((_rawCmdID>simx_cmd4bytes2strings_start)&&(_rawCmdID<simx_cmd4bytes2strings_end))
-    {
-        commandByteDataSize=4;
-        commandStringDataSize=int(_cmdString.length()+_cmdString2.length()+2);
-    }
+    int commandByteDataSize,commandStringDataSize;
+    _getCommandDataSizes(commandByteDataSize,commandStringDataSize);
 
     //3. We have the total length of this command, and can decide how much we wanna send each time:
     int totExceptHeaderAndPureData=commandByteDataSize+commandStringDataSize;
-    int pureDataPart=_pureDataSize;
-    int pureDataOffset=0;
+    int pureDataOffset;
+    int pureDataPart=_getSplitDataPart(pureDataOffset);
     if (_pureDataSize>_processingDelayOrMaxDataSize)
-    { // we can't send everything at once
-        if (_processingDelayOrMaxDataSize<_dataSizeLeftToBeSent)
-        {
-            pureDataPart=_processingDelayOrMaxDataSize;
-        }
-        else
-        {
-            pureDataPart=_dataSizeLeftToBeSent;
-        }
-        pureDataOffset=_pureDataSize-_dataSizeLeftToBeSent;
+    {
         _dataSizeLeftToBeSent-=pureDataPart;
         if (_dataSizeLeftToBeSent<0)
             _dataSizeLeftToBeSent=0;
@@ -239,30 +639,27 @@ bool CSimxCmd::appendYourMemorizedSplitData(bool calledFromContainer,std::vector
     ((int*)(header+simx_cmdheaderoffset_sim_time))[0]=littleEndianIntConversion(_executionTime,otherSideIsBigEndian);
 
 
-    //4. Append the sub-header:
-    for (int i=0;i<SIMX_SUBHEADER_SIZE;i++)
-        dataString.push_back(header[i]);
-    //5. Append the command data:
-    for (int i=0;i<commandByteDataSize;i++)
-        dataString.push_back(_cmdData[i]);
-    if (commandStringDataSize>0)
-    {
-        for (size_t i=0;i<_cmdString.size();i++)
-            dataString.push_back(_cmdString[i]);
-        dataString.push_back(0); // terminal zero
-        if (commandStringDataSize>int(_cmdString.size()+1))
-        { // we have a second string
-            for (size_t i=0;i<_cmdString2.size();i++)
-                dataString.push_back(_cmdString2[i]);
-            dataString.push_back(0); // terminal zero
-        }
-    }
-    //6. Append the auxiliary data, but only the part we need to send now:
-    for (int i=0;i<pureDataPart;i++)
-        dataString.push_back(_pureData[pureDataOffset+i]);
+    //4. Write the sub-header:
+    memcpy(dest,header,SIMX_SUBHEADER_SIZE);
+    //5. Write the command data:
+    dest=_writeCommandData(dest+SIMX_SUBHEADER_SIZE,commandByteDataSize,commandStringDataSize);
+    //6. Write the auxiliary data, but only the part we need to send now:
+    if (pureDataPart>0)
+        memcpy(dest,_pureData+pureDataOffset,pureDataPart);
+    dest+=pureDataPart;
     return(true);
 }
 
+bool CSimxCmd::appendYourMemorizedSplitData(bool calledFromContainer,std::vector<char>& dataString,bool& removeCommand,bool otherSideIsBigEndian)
+{
+    size_t off=dataString.size();
+    dataString.resize(off+getYourMemorizedSplitDataSize(calledFromContainer));
+    char* dest=NULL;
+    if (!dataString.empty())
+        dest=&dataString[0]+off;
+    return(writeYourMemorizedSplitData(calledFromContainer,dest,removeCommand,otherSideIsBigEndian));
+}
+
 void CSimxCmd::appendIntToString(std::string& str,int v,bool doConversion,bool otherSideIsBigEndian)
 {
     char* vp=(char*)(&v);
@@ -306,9 +703,7 @@ void CSimxCmd::setDataReply_nothing(bool success)
     _status=0;
     if (!success)
         _status|=1;
-    delete[] _pureData;
-    _pureData=NULL;
-    _pureDataSize=0;
+    _releasePureData();
 }
 
 void CSimxCmd::setDataReply_custom_transferBuffer(char* customData,int customDataSize,bool success)
@@ -316,8 +711,8 @@ void CSimxCmd::setDataReply_custom_transferBuffer(char* customData,int customDat
     _status=0;
     if (!success)
         _status|=1;
-    delete[] _pureData;
-    _pureData=customData;
+    _releasePureData();
+    _pureData=customData; // a heap buffer
     _pureDataSize=customDataSize;
 }
 
@@ -326,11 +721,9 @@ void CSimxCmd::setDataReply_custom_copyBuffer(char* customData,int customDataSiz
     _status=0;
     if (!success)
         _status|=1;
-    delete[] _pureData;
-    _pureData=new char[customDataSize];
-    for (int i=0;i<customDataSize;i++)
-        _pureData[i]=customData[i];
-    _pureDataSize=customDataSize;
+    _setPureDataSize(customDataSize);
+    if (customDataSize>0)
+        memcpy(_pureData,customData,customDataSize);
 }
 
 void CSimxCmd::setDataReply_1float(float floatVal,bool success,bool otherSideIsBigEndian)
@@ -338,13 +731,8 @@ void CSimxCmd::setDataReply_1float(float floatVal,bool success,bool otherSideIsB
     _status=0;
     if (!success)
         _status|=1;
-    if (_pureDataSize!=4)
-    {
-        delete[] _pureData;
-        _pureData=new char[4];
-        _pureDataSize=4;
-        ((float*)_pureData)[0]=littleEndianFloatConversion(floatVal,otherSideIsBigEndian);
-    }
+    _setPureDataSize(4);
+    ((float*)_pureData)[0]=littleEndianFloatConversion(floatVal,otherSideIsBigEndian);
 }
 
 void CSimxCmd::setDataReply_1int(int intVal,bool success,bool otherSideIsBigEndian)
@@ -352,13 +740,8 @@ void CSimxCmd::setDataReply_1int(int intVal,bool success,bool otherSideIsBigEndi
     _status=0;
     if (!success)
         _status|=1;
-    if (_pureDataSize!=4)
-    {
-        delete[] _pureData;
-        _pureData=new char[4];
-        _pureDataSize=4;
-        ((int*)_pureData)[0]=littleEndianIntConversion(intVal,otherSideIsBigEndian);
-    }
+    _setPureDataSize(4);
+    ((int*)_pureData)[0]=littleEndianIntConversion(intVal,otherSideIsBigEndian);
 }
 
 void CSimxCmd::setDataReply_2int(int intVal1,int intVal2,bool success,bool otherSideIsBigEndian)
@@ -366,14 +749,9 @@ void CSimxCmd::setDataReply_2int(int intVal1,int intVal2,bool success,bool other
     _status=0;
     if (!success)
         _status|=1;
-    if (_pureDataSize!=8)
-    {
-        delete[] _pureData;
-        _pureData=new char[8];
-        _pureDataSize=8;
-        ((int*)_pureData)[0]=littleEndianIntConversion(intVal1,otherSideIsBigEndian);
-        ((int*)_pureData)[1]=littleEndianIntConversion(intVal2,otherSideIsBigEndian);
-    }
+    _setPureDataSize(8);
+    ((int*)_pureData)[0]=littleEndianIntConversion(intVal1,otherSideIsBigEndian);
+    ((int*)_pureData)[1]=littleEndianIntConversion(intVal2,otherSideIsBigEndian);
 }
 
 void CSimxCmd::setDataReply_3int(int intVal1,int intVal2,int intVal3,bool success,bool otherSideIsBigEndian)
@@ -381,19 +759,25 @@ void CSimxCmd::setDataReply_3int(int intVal1,int intVal2,int intVal3,bool succes
     _status=0;
     if (!success)
         _status|=1;
-    if (_pureDataSize!=12)
-    {
-        delete[] _pureData;
-        _pureData=new char[12];
-        _pureDataSize=12;
-        ((int*)_pureData)[0]=littleEndianIntConversion(intVal1,otherSideIsBigEndian);
-        ((int*)_pureData)[1]=littleEndianIntConversion(intVal2,otherSideIsBigEndian);
-        ((int*)_pureData)[2]=littleEndianIntConversion(intVal3,otherSideIsBigEndian);
-    }
+    _setPureDataSize(12);
+    ((int*)_pureData)[0]=littleEndianIntConversion(intVal1,otherSideIsBigEndian);
+    ((int*)_pureData)[1]=littleEndianIntConversion(intVal2,otherSideIsBigEndian);
+    ((int*)_pureData)[2]=littleEndianIntConversion(intVal3,otherSideIsBigEndian);
 }
 
 CSimxCmd* CSimxCmd::copyYourself()
 {
+    CSimxCmd* newCmd=copyYourIdentity();
+    if (_memorizedSplitCmd!=NULL)
+        newCmd->_memorizedSplitCmd=_memorizedSplitCmd->copyYourself();
+    newCmd->_setPureDataSize(_pureDataSize);
+    if (_pureDataSize>0)
+        memcpy(newCmd->_pureData,_pureData,_pureDataSize);
+    return(newCmd);
+}
+
+CSimxCmd* CSimxCmd::copyYourIdentity()
+{ // copies everything but the pure data and the memorized split command. Replies are built from that
     CSimxCmd* newCmd=new CSimxCmd();
 
     newCmd->_rawCmdID=_rawCmdID;
@@ -405,21 +789,18 @@ CSimxCmd* CSimxCmd::copyYourself()
     newCmd->_cmdString=_cmdString;
     newCmd->_cmdString2=_cmdString2;
     newCmd->_executionTime=_executionTime;
-    if (_memorizedSplitCmd!=NULL)
-        newCmd->_memorizedSplitCmd=_memorizedSplitCmd->copyYourself();
-    else
-        newCmd->_memorizedSplitCmd=NULL;
-    for (int i=0;i<8;i++)
-        newCmd->_cmdData[i]=_cmdData[i];
-    newCmd->_pureDataSize=_pureDataSize;
-    if (_pureData!=NULL)
-    {
-        newCmd->_pureData=new char[_pureDataSize];
-        for (int i=0;i<_pureDataSize;i++)
-            newCmd->_pureData[i]=_pureData[i];
-    }
-    else
-        newCmd->_pureData=NULL;
+    newCmd->_memorizedSplitCmd=NULL;
+    newCmd->_sendOnlyOnChange=false;
+    newCmd->_hasLastSentReply=false;
+    newCmd->_lastSentReplyStatus=0;
+    newCmd->_lastSentReplyTime=0;
+    newCmd->_deltaEncoding=false;
+    newCmd->_lastKeyframeTime=0;
+    newCmd->_compression=false;
+    memcpy(newCmd->_cmdData,_cmdData,8);
+    newCmd->_pureData=NULL;
+    newCmd->_pureDataSize=0;
+    newCmd->_pureDataCapacity=0;
 
     return(newCmd);
 }
@@ -451,9 +832,7 @@ CSimxCmd* CSimxCmd::execute(CSimxSocket* sock,bool otherSideIsBigEndian)
 
     if (_opMode==simx_opmode_discontinue)
     { // we send back the discontinue command, without executing it here!
-        retCmd=copyYourself();
-        delete retCmd->_memorizedSplitCmd; // probably not necessary
-        retCmd->_memorizedSplitCmd=NULL;
+        retCmd=copyYourIdentity();
         retCmd->setDataReply_nothing(true);
         return(retCmd);
     }
@@ -461,15 +840,16 @@ CSimxCmd* CSimxCmd::execute(CSimxSocket* sock,bool otherSideIsBigEndian)
     if ( ((_opMode!=simx_opmode_continuous_split)&&(_opMode!=simx_opmode_oneshot_split))||(_dataSizeLeftToBeSent==0) )
         retCmd=_executeCommand(sock,otherSideIsBigEndian);
 
+    if (retCmd!=NULL)
+        retCmd=_encodeReply(retCmd,ct,otherSideIsBigEndian);
+
     // Prepare to concatenate the data here (if needed).
     if ((_opMode==simx_opmode_continuous_split)||(_opMode==simx_opmode_oneshot_split))
     { // in this mode we reprocess the command only once all parts were sent. These commands will not automatically be put into the output container like other commands
         if (_dataSizeLeftToBeSent==0)
         {
             delete _memorizedSplitCmd;
-            delete retCmd->_memorizedSplitCmd;
-            retCmd->_memorizedSplitCmd=NULL;
-            _memorizedSplitCmd=retCmd;
+            _memorizedSplitCmd=retCmd; // retCmd has no memorized split command itself
             _dataSizeLeftToBeSent=_memorizedSplitCmd->_pureDataSize;
         }
         retCmd=NULL;
@@ -478,6 +858,129 @@ CSimxCmd* CSimxCmd::execute(CSimxSocket* sock,bool otherSideIsBigEndian)
     return(retCmd);
 }
 
+CSimxCmd* CSimxCmd::_encodeReply(CSimxCmd* retCmd,int currentTime,bool otherSideIsBigEndian)
+{ // Applies the reply options the client asked for. Returns NULL if the reply is not sent
+    if (_deltaEncoding&&(_opMode==simx_opmode_continuous))
+    {
+        const SSimxCmdDescriptor* descriptor=getCommandDescriptor(_rawCmdID);
+        if ((descriptor!=NULL)&&(descriptor->flags&SIMX_CMDFLAG_IMAGEREPLY))
+            _deltaEncodeReply(retCmd,currentTime,otherSideIsBigEndian);
+    }
+
+    if (_sendOnlyOnChange&&(_opMode==simx_opmode_continuous))
+        retCmd=_suppressUnchangedReply(retCmd,currentTime); // a delta without changed tiles is suppressed like any unchanged reply
+
+    if ((retCmd!=NULL)&&_compression)
+        _compressReply(retCmd,otherSideIsBigEndian); // split replies are compressed as a whole
+    return(retCmd);
+}
+
+CSimxCmd* CSimxCmd::_suppressUnchangedReply(CSimxCmd* retCmd,int currentTime)
+{ // An unchanged reply is dropped, or sent without its data as keep-alive marker once every SIMX_SENDONLYONCHANGE_KEEPALIVE ms
+    bool unchanged=_hasLastSentReply&&(retCmd->_status==_lastSentReplyStatus)&&(retCmd->_pureDataSize==int(_lastSentReply.size()));
+    if (unchanged&&(retCmd->_pureDataSize>0))
+        unchanged=(memcmp(retCmd->_pureData,&_lastSentReply[0],retCmd->_pureDataSize)==0);
+    if (!unchanged)
+    {
+        _lastSentReply.assign(retCmd->_pureData,retCmd->_pureData+retCmd->_pureDataSize);
+        _lastSentReplyStatus=retCmd->_status;
+        _lastSentReplyTime=currentTime;
+        _hasLastSentReply=true;
+        return(retCmd);
+    }
+    if (currentTime-_lastSentReplyTime<SIMX_SENDONLYONCHANGE_KEEPALIVE)
+    {
+        delete retCmd;
+        return(NULL);
+    }
+    _lastSentReplyTime=currentTime;
+    retCmd->_releasePureData();
+    retCmd->_status|=SIMX_CMDSTATUS_UNCHANGED;
+    return(retCmd);
+}
+
+void CSimxCmd::_deltaEncodeReply(CSimxCmd* retCmd,int currentTime,bool otherSideIsBigEndian)
+{ // Replaces the image reply with the tiles that changed since the last frame sent, unless a keyframe is due
+    int frameSize=retCmd->_pureDataSize;
+    if (((retCmd->_status&1)!=0)||(frameSize<8))
+    { // error: the next frame will be a keyframe
+        _lastSentFrame.clear();
+        return;
+    }
+    bool keyframe=(frameSize!=int(_lastSentFrame.size()))||(currentTime-_lastKeyframeTime>=SIMX_DELTA_KEYFRAME_INTERVAL);
+    if ((!keyframe)&&(memcmp(retCmd->_pureData,&_lastSentFrame[0],8)!=0))
+        keyframe=true; // resolution changed
+    int deltaSize=0;
+    if (!keyframe)
+    { // find the changed tiles:
+        const char* frame=retCmd->_pureData+8;
+        char* lastFrame=&_lastSentFrame[8];
+        int pixelDataSize=frameSize-8;
+        deltaSize=16;
+        _changedTiles.clear();
+        for (int i=0;i*SIMX_DELTA_TILE_SIZE<pixelDataSize;i++)
+        {
+            int off=i*SIMX_DELTA_TILE_SIZE;
+            int tileSize=pixelDataSize-off;
+            if (tileSize>SIMX_DELTA_TILE_SIZE)
+                tileSize=SIMX_DELTA_TILE_SIZE;
+            if (memcmp(frame+off,lastFrame+off,tileSize)!=0)
+            {
+                _changedTiles.push_back(i);
+                deltaSize+=4+tileSize;
+            }
+        }
+        keyframe=(deltaSize>=frameSize); // the delta wouldn't save anything
+    }
+    if (keyframe)
+    {
+        _lastSentFrame.assign(retCmd->_pureData,retCmd->_pureData+frameSize);
+        _lastKeyframeTime=currentTime;
+        return;
+    }
+
+    // Update the client's frame, then build the delta from it (the reply's buffer is reallocated):
+    int pixelDataSize=frameSize-8;
+    for (unsigned int i=0;i<_changedTiles.size();i++)
+    {
+        int off=_changedTiles[i]*SIMX_DELTA_TILE_SIZE;
+        int tileSize=pixelDataSize-off;
+        if (tileSize>SIMX_DELTA_TILE_SIZE)
+            tileSize=SIMX_DELTA_TILE_SIZE;
+        memcpy(&_lastSentFrame[8+off],retCmd->_pureData+8+off,tileSize);
+    }
+    char* dest=retCmd->_setPureDataSize(deltaSize);
+    memcpy(dest,&_lastSentFrame[0],8);
+    ((int*)(dest+8))[0]=littleEndianIntConversion(SIMX_DELTA_TILE_SIZE,otherSideIsBigEndian);
+    ((int*)(dest+8))[1]=littleEndianIntConversion(int(_changedTiles.size()),otherSideIsBigEndian);
+    dest+=16;
+    for (unsigned int i=0;i<_changedTiles.size();i++)
+    {
+        int off=_changedTiles[i]*SIMX_DELTA_TILE_SIZE;
+        int tileSize=pixelDataSize-off;
+        if (tileSize>SIMX_DELTA_TILE_SIZE)
+            tileSize=SIMX_DELTA_TILE_SIZE;
+        ((int*)dest)[0]=littleEndianIntConversion(_changedTiles[i],otherSideIsBigEndian);
+        memcpy(dest+4,&_lastSentFrame[8+off],tileSize);
+        dest+=4+tileSize;
+    }
+    retCmd->_status|=SIMX_CMDSTATUS_DELTA;
+}
+
+void CSimxCmd::_compressReply(CSimxCmd* retCmd,bool otherSideIsBigEndian)
+{ // The reply stays uncompressed if compression doesn't make it smaller
+    if ((retCmd->_pureDataSize<SIMX_COMPRESSION_MIN_SIZE)||((retCmd->_status&1)!=0))
+        return;
+    if (int(_compressionBuffer.size())<retCmd->_pureDataSize)
+        _compressionBuffer.resize(retCmd->_pureDataSize);
+    int compressedSize=lz4Compress(retCmd->_pureData,retCmd->_pureDataSize,&_compressionBuffer[4],retCmd->_pureDataSize-4-1); // must save at least one byte
+    if (compressedSize==0)
+        return;
+    ((int*)&_compressionBuffer[0])[0]=littleEndianIntConversion(retCmd->_pureDataSize,otherSideIsBigEndian);
+    memcpy(retCmd->_setPureDataSize(4+compressedSize),&_compressionBuffer[0],4+compressedSize);
+    retCmd->_status|=SIMX_CMDSTATUS_COMPRESSED;
+}
+
 CSimxCmd* CSimxCmd::_executeCommand(CSimxSocket* sock,bool otherSideIsBigEndian)
 {
     if (simGetSimulationState()==sim_simulation_stopped)
@@ -485,1610 +988,1661 @@ CSimxCmd* CSimxCmd::_executeCommand(CSimxSocket* sock,bool otherSideIsBigEndian)
     else
         _executionTime=int(simGetSimulationTime()*1000.01f);
 
-    CSimxCmd* retCmd=copyYourself();
+    CSimxCmd* retCmd=copyYourIdentity(); // handlers set the reply data. The request's pure data is not copied
     retCmd->_status|=1; // this means error on the server side. The flag will be cleared if the execution was successful
 
-    switch (_rawCmdID) {
-    	case simx_cmd_get_joint_position:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float pos=0.0f;
-            bool success=(simGetJointPosition(handle,&pos)!=-1);
-            retCmd->setDataReply_1float(pos,success,otherSideIsBigEndian);
-        }
-    	break;
+    const SSimxCmdDescriptor* descriptor=getCommandDescriptor(_rawCmdID);
+    if (descriptor!=NULL)
+        (this->*descriptor->handler)(retCmd,sock,otherSideIsBigEndian);
 
-    	case simx_cmd_get_joint_matrix:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float matrix[12];
-            bool success=(simGetJointMatrix(handle,matrix)!=-1);
-            if (success)
-            {
-                for (int i=0;i<12;i++)
-                    matrix[i]=littleEndianFloatConversion(matrix[i],otherSideIsBigEndian);
-            }
-            retCmd->setDataReply_custom_copyBuffer((char*)matrix,12*4,success);
-        }
-    	break;
+    // ******************************* error reporting **********************************
+    char* err=simGetLastError(); // this also clears the last error
+    if (err!=NULL)
+    {
+        sock->addErrorString(err);
+        simReleaseBuffer(err);
+    }
+    return(retCmd);
+}
 
-    	case simx_cmd_read_proximity_sensor:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float detectedPoint[4];
-            int detectedObjectHandle;
-            float detectedSurfaceNormalVector[3];
-            int res=simReadProximitySensor(handle,detectedPoint,&detectedObjectHandle,detectedSurfaceNormalVector);
-            bool success=(res!=-1);
-            char data[29];
-            data[0]=char(res);
-            ((float*)(data+1))[0]=littleEndianFloatConversion(detectedPoint[0],otherSideIsBigEndian);
-            ((float*)(data+5))[0]=littleEndianFloatConversion(detectedPoint[1],otherSideIsBigEndian);
-            ((float*)(data+9))[0]=littleEndianFloatConversion(detectedPoint[2],otherSideIsBigEndian);
-            ((int*)(data+13))[0]=littleEndianIntConversion(detectedObjectHandle,otherSideIsBigEndian);
-            ((float*)(data+17))[0]=littleEndianFloatConversion(detectedSurfaceNormalVector[0],otherSideIsBigEndian);
-            ((float*)(data+21))[0]=littleEndianFloatConversion(detectedSurfaceNormalVector[1],otherSideIsBigEndian);
-            ((float*)(data+25))[0]=littleEndianFloatConversion(detectedSurfaceNormalVector[2],otherSideIsBigEndian);
-            retCmd->setDataReply_custom_copyBuffer(data,29,success);
-        }
-    	break;
+void CSimxCmd::_executeGetJointPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float pos=0.0f;
+    bool success=(simGetJointPosition(handle,&pos)!=-1);
+    retCmd->setDataReply_1float(pos,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_object_handle:
-        {
-            int handle=simGetObjectHandle(_cmdString.c_str());
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetJointMatrix(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float matrix[12];
+    bool success=(simGetJointMatrix(handle,matrix)!=-1);
+    if (success)
+    {
+        for (int i=0;i<12;i++)
+            matrix[i]=littleEndianFloatConversion(matrix[i],otherSideIsBigEndian);
+    }
+    retCmd->setDataReply_custom_copyBuffer((char*)matrix,12*4,success);
+}
 
-    	case simx_cmd_get_ui_handle:
-        {
-            int handle=simGetUIHandle(_cmdString.c_str());
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeReadProximitySensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float detectedPoint[4];
+    int detectedObjectHandle;
+    float detectedSurfaceNormalVector[3];
+    int res=simReadProximitySensor(handle,detectedPoint,&detectedObjectHandle,detectedSurfaceNormalVector);
+    bool success=(res!=-1);
+    char data[29];
+    data[0]=char(res);
+    ((float*)(data+1))[0]=littleEndianFloatConversion(detectedPoint[0],otherSideIsBigEndian);
+    ((float*)(data+5))[0]=littleEndianFloatConversion(detectedPoint[1],otherSideIsBigEndian);
+    ((float*)(data+9))[0]=littleEndianFloatConversion(detectedPoint[2],otherSideIsBigEndian);
+    ((int*)(data+13))[0]=littleEndianIntConversion(detectedObjectHandle,otherSideIsBigEndian);
+    ((float*)(data+17))[0]=littleEndianFloatConversion(detectedSurfaceNormalVector[0],otherSideIsBigEndian);
+    ((float*)(data+21))[0]=littleEndianFloatConversion(detectedSurfaceNormalVector[1],otherSideIsBigEndian);
+    ((float*)(data+25))[0]=littleEndianFloatConversion(detectedSurfaceNormalVector[2],otherSideIsBigEndian);
+    retCmd->setDataReply_custom_copyBuffer(data,29,success);
+}
 
-    	case simx_cmd_load_model:
-        {
-            std::string tmp(_cmdString);
-            if (_cmdString.compare(0,20,"REMOTE_API_TEMPFILE_")==0)
-            {
-                char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
-                tmp=path;
-                simReleaseBuffer(path);
-                tmp+="/";
-                tmp+=_cmdString;
-            }
-            simRemoveObjectFromSelection(sim_handle_all,-1);
-            int initValue=simGetBooleanParameter(sim_boolparam_scene_and_model_load_messages);
-            simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,0);
-            bool success=(simLoadModel(tmp.c_str())!=-1);
-            simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,initValue);
-            int handle=simGetObjectLastSelection();
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=simGetObjectHandle(_cmdString.c_str());
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_load_scene:
-        {
-            std::string tmp(_cmdString);
-            if (_cmdString.compare(0,20,"REMOTE_API_TEMPFILE_")==0)
-            {
-                char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
-                tmp=path;
-                simReleaseBuffer(path);
-                tmp+="/";
-                tmp+=_cmdString;
-            }
-            int initValue=simGetBooleanParameter(sim_boolparam_scene_and_model_load_messages);
-            simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,0);
-            bool success=(simLoadScene(tmp.c_str())!=-1);
-            simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,initValue);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetUiHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=simGetUIHandle(_cmdString.c_str());
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_joint_position:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float pos=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetJointPosition(handle,pos)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeLoadModel(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    std::string tmp(_cmdString);
+    if (_cmdString.compare(0,20,"REMOTE_API_TEMPFILE_")==0)
+    {
+        char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
+        tmp=path;
+        simReleaseBuffer(path);
+        tmp+="/";
+        tmp+=_cmdString;
+    }
+    simRemoveObjectFromSelection(sim_handle_all,-1);
+    int initValue=simGetBooleanParameter(sim_boolparam_scene_and_model_load_messages);
+    simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,0);
+    bool success=(simLoadModel(tmp.c_str())!=-1);
+    simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,initValue);
+    int handle=simGetObjectLastSelection();
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_spherical_joint_matrix:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float matrix[12];
-            for (int i=0;i<12;i++)
-                matrix[i]=littleEndianFloatConversion(((float*)_pureData)[i],otherSideIsBigEndian);
-            bool success=(simSetSphericalJointMatrix(handle,matrix)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeLoadScene(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    std::string tmp(_cmdString);
+    if (_cmdString.compare(0,20,"REMOTE_API_TEMPFILE_")==0)
+    {
+        char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
+        tmp=path;
+        simReleaseBuffer(path);
+        tmp+="/";
+        tmp+=_cmdString;
+    }
+    int initValue=simGetBooleanParameter(sim_boolparam_scene_and_model_load_messages);
+    simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,0);
+    bool success=(simLoadScene(tmp.c_str())!=-1);
+    simSetBooleanParameter(sim_boolparam_scene_and_model_load_messages,initValue);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_joint_target_velocity:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float vel=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetJointTargetVelocity(handle,vel)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetJointPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float pos=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetJointPosition(handle,pos)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_joint_target_position:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float pos=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetJointTargetPosition(handle,pos)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetSphericalJointMatrix(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float matrix[12];
+    for (int i=0;i<12;i++)
+        matrix[i]=littleEndianFloatConversion(((float*)_pureData)[i],otherSideIsBigEndian);
+    bool success=(simSetSphericalJointMatrix(handle,matrix)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_start_pause_stop_simulation:
-        {
-            int v=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=false;
-            if (v==0)
-                success=(simStartSimulation()!=-1);
-            if (v==1)
-                success=(simPauseSimulation()!=-1);
-            if (v==2)
-                success=(simStopSimulation()!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetJointTargetVelocity(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float vel=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetJointTargetVelocity(handle,vel)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeSetJointTargetPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float pos=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetJointTargetPosition(handle,pos)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeStartPauseStopSimulation(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int v=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=false;
+    if (v==0)
+        success=(simStartSimulation()!=-1);
+    if (v==1)
+        success=(simPauseSimulation()!=-1);
+    if (v==2)
+        success=(simStopSimulation()!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_synchronous_next:
+void CSimxCmd::_executeSynchronousNext(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    bool success=false;
+    if (sock->getWaitForTriggerEnabled())
+    {
+        if ((simGetSimulationState()&sim_simulation_advancing)!=0)
         {
-            bool success=false;
-            if (sock->getWaitForTriggerEnabled())
-            {
-                if ((simGetSimulationState()&sim_simulation_advancing)!=0)
-                {
-                    sock->setWaitForTrigger(false);
-                    success=true;
-                }
-            }
-            retCmd->setDataReply_nothing(success);
+            sock->setWaitForTrigger(false);
+            success=true;
         }
-        break;
-    	case simx_cmd_synchronous_enable:
-        {
-            bool success=false;
-            if (sock->getWaitForTriggerAuthorized())
-            {
-                sock->setWaitForTriggerEnabled(true);
-                success=true;
-            }
-            retCmd->setDataReply_nothing(success);
+    }
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeSynchronousEnable(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    bool success=false;
+    if (sock->getWaitForTriggerAuthorized())
+    {
+        sock->setWaitForTriggerEnabled(true);
+        success=true;
+    }
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeSynchronousDisable(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    bool success=false;
+    if (sock->getWaitForTriggerAuthorized())
+    {
+        sock->setWaitForTriggerEnabled(false);
+        success=true;
+    }
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeGetVisionSensorImage(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res[2];
+    bool success=false;
+    if (simGetVisionSensorResolution(handle,res)!=-1)
+    {
+        int bytesPerPixel;
+    	if(_rawCmdID == simx_cmd_get_vision_sensor_image_bw) {
+            bytesPerPixel=1;
         }
-        break;
-    	case simx_cmd_synchronous_disable:
-        {
-            bool success=false;
-            if (sock->getWaitForTriggerAuthorized())
-            {
-                sock->setWaitForTriggerEnabled(false);
-                success=true;
-            }
-            retCmd->setDataReply_nothing(success);
+    	if(_rawCmdID == simx_cmd_get_vision_sensor_image_rgb) {
+            bytesPerPixel=3;
         }
-        break;
 
-        case simx_cmd_get_vision_sensor_image_bw: // fall-through
-        case simx_cmd_get_vision_sensor_image_rgb:
+        unsigned char* img=simGetVisionSensorCharImage(handle,NULL,NULL);
+        if (img!=NULL)
         {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int res[2];
-            bool success=false;
-            if (simGetVisionSensorResolution(handle,res)!=-1)
-            {
-                int bytesPerPixel;
-            	if(_rawCmdID == simx_cmd_get_vision_sensor_image_bw) {
-                    bytesPerPixel=1;
-                }
-            	if(_rawCmdID == simx_cmd_get_vision_sensor_image_rgb) {
-                    bytesPerPixel=3;
-                }
-
-                char* dat=new char[4+4+res[0]*res[1]*bytesPerPixel];
-                unsigned char* img=simGetVisionSensorCharImage(handle,NULL,NULL);
-                if (img!=NULL)
-                {
-                    success=true;
-                    ((int*)(dat+0))[0]=littleEndianIntConversion(res[0],otherSideIsBigEndian);
-                    ((int*)(dat+0))[1]=littleEndianIntConversion(res[1],otherSideIsBigEndian);
-                    if (bytesPerPixel==1)
-                    {
-                        for (int i=0;i<res[0]*res[1];i++)
-                            dat[8+i]=char((img[3*i+0]+img[3*i+1]+img[3*i+2])/3);
-                    }
-                    if (bytesPerPixel==3)
-                    {
-                        for (int i=0;i<res[0]*res[1]*3;i++)
-                            dat[8+i]=img[i];
-                    }
-                    simReleaseBuffer((simChar*)img);
-                    retCmd->setDataReply_custom_transferBuffer(dat,4+4+res[0]*res[1]*bytesPerPixel,success);
-                }
-                else
-                    delete[] dat;
-            }
-            if (!success)
-                retCmd->setDataReply_nothing(success);
+            success=true;
+            char* dat=retCmd->_setPureDataSize(4+4+res[0]*res[1]*bytesPerPixel);
+            ((int*)(dat+0))[0]=littleEndianIntConversion(res[0],otherSideIsBigEndian);
+            ((int*)(dat+0))[1]=littleEndianIntConversion(res[1],otherSideIsBigEndian);
+            if (bytesPerPixel==1)
+                convertRgbToGray(img,(BYTE*)dat+8,res[0]*res[1]);
+            if (bytesPerPixel==3)
+                memcpy(dat+8,img,res[0]*res[1]*3);
+            simReleaseBuffer((simChar*)img);
+            retCmd->_status=0;
         }
-        break;
+    }
+    if (!success)
+        retCmd->setDataReply_nothing(success);
+}
 
-        case simx_cmd_set_vision_sensor_image_bw: // fall-through
-        case simx_cmd_set_vision_sensor_image_rgb:
+void CSimxCmd::_executeSetVisionSensorImage(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res[2];
+    bool success=false;
+    if (simGetVisionSensorResolution(handle,res)!=-1)
+    {
+        int bytesPerPixel;
+        if(_rawCmdID == simx_cmd_get_vision_sensor_image_bw) {
+            bytesPerPixel=1;
+        }
+    	if(_rawCmdID == simx_cmd_get_vision_sensor_image_rgb) {
+            bytesPerPixel=3;
+        }
+        if (res[0]*res[1]*bytesPerPixel==_pureDataSize)
         {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int res[2];
-            bool success=false;
-            if (simGetVisionSensorResolution(handle,res)!=-1)
+            unsigned char* img=new unsigned char[res[0]*res[1]*3];
+            if (bytesPerPixel==1)
             {
-                int bytesPerPixel;
-                if(_rawCmdID == simx_cmd_get_vision_sensor_image_bw) {
-                    bytesPerPixel=1;
-                }
-            	if(_rawCmdID == simx_cmd_get_vision_sensor_image_rgb) {
-                    bytesPerPixel=3;
-                }
-                if (res[0]*res[1]*bytesPerPixel==_pureDataSize)
+                for (int i=0;i<_pureDataSize;i++)
                 {
-                    unsigned char* img=new unsigned char[res[0]*res[1]*3];
-                    if (bytesPerPixel==1)
-                    {
-                        for (int i=0;i<_pureDataSize;i++)
-                        {
-                            img[3*i+0]=_pureData[i];
-                            img[3*i+1]=_pureData[i];
-                            img[3*i+2]=_pureData[i];
-                        }
-                    }
-                    if (bytesPerPixel==3)
-                    {
-                        for (int i=0;i<_pureDataSize;i++)
-                            img[i]=_pureData[i];
-                    }
-                    success=(simSetVisionSensorCharImage(handle,img)!=-1);
-                    delete[] img;
+                    img[3*i+0]=_pureData[i];
+                    img[3*i+1]=_pureData[i];
+                    img[3*i+2]=_pureData[i];
                 }
             }
-            retCmd->setDataReply_nothing(success);
+            if (bytesPerPixel==3)
+                memcpy(img,_pureData,_pureDataSize);
+            success=(simSetVisionSensorCharImage(handle,img)!=-1);
+            delete[] img;
         }
-    	break;
+    }
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_joint_force:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float f=0.0f;
-            bool success=(simJointGetForce(handle,&f)!=-1);
-            retCmd->setDataReply_1float(f,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetJointForce(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float f=0.0f;
+    bool success=(simJointGetForce(handle,&f)!=-1);
+    retCmd->setDataReply_1float(f,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_joint_force:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float f=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetJointForce(handle,f)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetJointForce(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float f=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetJointForce(handle,f)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_read_force_sensor:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float forceV[3];
-            float torqueV[3];
-            int res=simReadForceSensor(handle,forceV,torqueV);
-            char dat[25];
-            dat[0]=0;
-            if (res>=0)
-                dat[0]=BYTE(res);
-            for (int i=0;i<3;i++)
-                ((float*)(dat+1))[i]=littleEndianFloatConversion(forceV[i],otherSideIsBigEndian);
-            for (int i=0;i<3;i++)
-                ((float*)(dat+13))[i]=littleEndianFloatConversion(torqueV[i],otherSideIsBigEndian);
-            bool success=(res!=-1);
-            retCmd->setDataReply_custom_copyBuffer(dat,25,success);
-        }
-    	break;
+void CSimxCmd::_executeReadForceSensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float forceV[3];
+    float torqueV[3];
+    int res=simReadForceSensor(handle,forceV,torqueV);
+    char dat[25];
+    dat[0]=0;
+    if (res>=0)
+        dat[0]=BYTE(res);
+    for (int i=0;i<3;i++)
+        ((float*)(dat+1))[i]=littleEndianFloatConversion(forceV[i],otherSideIsBigEndian);
+    for (int i=0;i<3;i++)
+        ((float*)(dat+13))[i]=littleEndianFloatConversion(torqueV[i],otherSideIsBigEndian);
+    bool success=(res!=-1);
+    retCmd->setDataReply_custom_copyBuffer(dat,25,success);
+}
 
-    	case simx_cmd_break_force_sensor:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=(simBreakForceSensor(handle)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeBreakForceSensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=(simBreakForceSensor(handle)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_read_vision_sensor:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float* auxValues;
-            int* auxValuesCount;
-            int res=simReadVisionSensor(handle,&auxValues,&auxValuesCount);
-            if (res>=0)
-            {
-                int packetCnt=auxValuesCount[0];
-                int auxValCnt=0;
-                for (int i=0;i<packetCnt;i++)
-                    auxValCnt+=auxValuesCount[1+i];
-                char* buff=new char[1+4*(1+packetCnt+auxValCnt)];
-                buff[0]=BYTE(res);
-                for (int i=0;i<packetCnt+1;i++)
-                    ((int*)(buff+1))[i]=littleEndianIntConversion(auxValuesCount[i],otherSideIsBigEndian);
-                for (int i=0;i<auxValCnt;i++) // was for (int i=0;i<auxValCnt+1;i++), thanks to Billy Newman for noticing the bug
-                    ((float*)(buff+1))[packetCnt+1+i]=littleEndianFloatConversion(auxValues[i],otherSideIsBigEndian);
-                retCmd->setDataReply_custom_transferBuffer(buff,1+4*(1+packetCnt+auxValCnt),true);
-                simReleaseBuffer((char*)auxValues);
-                simReleaseBuffer((char*)auxValuesCount);
-            }
-            else
-                retCmd->setDataReply_1int(0,false,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeReadVisionSensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float* auxValues;
+    int* auxValuesCount;
+    int res=simReadVisionSensor(handle,&auxValues,&auxValuesCount);
+    if (res>=0)
+    {
+        int packetCnt=auxValuesCount[0];
+        int auxValCnt=0;
+        for (int i=0;i<packetCnt;i++)
+            auxValCnt+=auxValuesCount[1+i];
+        char* buff=retCmd->_setPureDataSize(1+4*(1+packetCnt+auxValCnt));
+        buff[0]=BYTE(res);
+        for (int i=0;i<packetCnt+1;i++)
+            ((int*)(buff+1))[i]=littleEndianIntConversion(auxValuesCount[i],otherSideIsBigEndian);
+        for (int i=0;i<auxValCnt;i++) // was for (int i=0;i<auxValCnt+1;i++), thanks to Billy Newman for noticing the bug
+            ((float*)(buff+1))[packetCnt+1+i]=littleEndianFloatConversion(auxValues[i],otherSideIsBigEndian);
+        retCmd->_status=0;
+        simReleaseBuffer((char*)auxValues);
+        simReleaseBuffer((char*)auxValuesCount);
+    }
+    else
+        retCmd->setDataReply_1int(0,false,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_object_parent:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int parent=simGetObjectParent(handle);
-    //      bool success=(parent!=-1);
-            retCmd->setDataReply_1int(parent,true,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectParent(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int parent=simGetObjectParent(handle);
+//      bool success=(parent!=-1);
+    retCmd->setDataReply_1int(parent,true,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_object_child:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int index=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int child=simGetObjectChild(handle,index);
-    //      bool success=(child!=-1);
-            retCmd->setDataReply_1int(child,true,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectChild(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int index=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int child=simGetObjectChild(handle,index);
+//      bool success=(child!=-1);
+    retCmd->setDataReply_1int(child,true,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_transfer_file:
-        {
-            char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
-            std::string tmp(path);
-            simReleaseBuffer(path);
-            tmp+="/";
-            tmp+=_cmdString;
-            FILE* file=fopen(tmp.c_str(),"wb");
-            bool success=(file!=NULL);
-            if (success)
-            {
-                fwrite(_pureData,1,_pureDataSize,file);
-                fclose(file);
-            }
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeTransferFile(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
+    std::string tmp(path);
+    simReleaseBuffer(path);
+    tmp+="/";
+    tmp+=_cmdString;
+    FILE* file=fopen(tmp.c_str(),"wb");
+    bool success=(file!=NULL);
+    if (success)
+    {
+        fwrite(_pureData,1,_pureDataSize,file);
+        fclose(file);
+    }
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_erase_file:
-        {
-            char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
-            std::string tmp(path);
-            simReleaseBuffer(path);
-            tmp+="/";
-            tmp+=_cmdString;
-            bool success=(remove(tmp.c_str())==0);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeEraseFile(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
+    std::string tmp(path);
+    simReleaseBuffer(path);
+    tmp+="/";
+    tmp+=_cmdString;
+    bool success=(remove(tmp.c_str())==0);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_load_ui:
-        {
-            std::string tmp(_cmdString);
-            if (_cmdString.compare(0,20,"REMOTE_API_TEMPFILE_")==0)
-            {
-                char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
-                tmp=path;
-                simReleaseBuffer(path);
-                tmp+="/";
-                tmp+=_cmdString;
-            }
-            int handles[1000];
-            int cnt=simLoadUI(tmp.c_str(),1000,handles);
-            bool success=(cnt!=-1);
-            if (!success)
-                cnt=0;
-            int* dat=new int[cnt+1];
-            dat[0]=littleEndianIntConversion(cnt,otherSideIsBigEndian);
-            for (int i=0;i<cnt;i++)
-                dat[1+i]=littleEndianIntConversion(handles[i],otherSideIsBigEndian);
-            retCmd->setDataReply_custom_transferBuffer((char*)dat,4*(cnt+1),success);
-        }
-    	break;
+void CSimxCmd::_executeLoadUi(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    std::string tmp(_cmdString);
+    if (_cmdString.compare(0,20,"REMOTE_API_TEMPFILE_")==0)
+    {
+        char* path=simGetStringParameter(sim_stringparam_remoteapi_temp_file_dir);
+        tmp=path;
+        simReleaseBuffer(path);
+        tmp+="/";
+        tmp+=_cmdString;
+    }
+    int handles[1000];
+    int cnt=simLoadUI(tmp.c_str(),1000,handles);
+    bool success=(cnt!=-1);
+    if (!success)
+        cnt=0;
+    int* dat=new int[cnt+1];
+    dat[0]=littleEndianIntConversion(cnt,otherSideIsBigEndian);
+    for (int i=0;i<cnt;i++)
+        dat[1+i]=littleEndianIntConversion(handles[i],otherSideIsBigEndian);
+    retCmd->setDataReply_custom_transferBuffer((char*)dat,4*(cnt+1),success);
+}
 
-    	case simx_cmd_get_ui_slider:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int pos=simGetUISlider(handle,buttonID);
-            bool success=(pos!=-1);
-            retCmd->setDataReply_1int(pos,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetUiSlider(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int pos=simGetUISlider(handle,buttonID);
+    bool success=(pos!=-1);
+    retCmd->setDataReply_1int(pos,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_ui_slider:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int pos=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetUISlider(handle,buttonID,pos)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetUiSlider(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int pos=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetUISlider(handle,buttonID,pos)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_ui_event_button:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int auxVals[2];
-            int buttonID=simGetUIEventButton(handle,auxVals);
-            if (buttonID!=-1)
-                _opMode=simx_opmode_oneshot; // an event was received. We need to remove this command! (this is a special case, only for this command. See the doc!)
-    //      bool success=(buttonID!=-1);
-            retCmd->setDataReply_3int(buttonID,auxVals[0],auxVals[1],true,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetUiEventButton(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int auxVals[2];
+    int buttonID=simGetUIEventButton(handle,auxVals);
+    if (buttonID!=-1)
+        _opMode=simx_opmode_oneshot; // an event was received. We need to remove this command! (this is a special case, only for this command. See the doc!)
+//      bool success=(buttonID!=-1);
+    retCmd->setDataReply_3int(buttonID,auxVals[0],auxVals[1],true,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_ui_button_property:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int prop=simGetUIButtonProperty(handle,buttonID);
-            bool success=(prop!=-1);
-            retCmd->setDataReply_1int(prop,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetUiButtonProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int prop=simGetUIButtonProperty(handle,buttonID);
+    bool success=(prop!=-1);
+    retCmd->setDataReply_1int(prop,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_ui_button_property:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int prop=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetUIButtonProperty(handle,buttonID,prop)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetUiButtonProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int prop=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetUIButtonProperty(handle,buttonID,prop)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_add_statusbar_message:
-        {
-            int res=simAddStatusbarMessage(_cmdString.c_str());
-            bool success=(res!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeAddStatusbarMessage(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int res=simAddStatusbarMessage(_cmdString.c_str());
+    bool success=(res!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_aux_console_open:
-        {
-            int maxLines=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            int mode=littleEndianIntConversion(((int*)(_pureData+0))[1],otherSideIsBigEndian);
-
-            int* pos=NULL;
-            int _pos[2];
-            _pos[0]=littleEndianIntConversion(((int*)(_pureData+0))[2],otherSideIsBigEndian);
-            _pos[1]=littleEndianIntConversion(((int*)(_pureData+0))[3],otherSideIsBigEndian);
-            if (_pos[0]!=98765)
-                pos=_pos; // arg is not NULL!
-
-            int* size=NULL;
-            int _size[2];
-            _size[0]=littleEndianIntConversion(((int*)(_pureData+0))[4],otherSideIsBigEndian);
-            _size[1]=littleEndianIntConversion(((int*)(_pureData+0))[5],otherSideIsBigEndian);
-            if (_size[0]!=98765)
-                size=_size; // arg is not NULL!
-
-            float* tcol=NULL;
-            float _tcol[3];
-            _tcol[0]=littleEndianFloatConversion(((float*)(_pureData+0))[6],otherSideIsBigEndian);
-            _tcol[1]=littleEndianFloatConversion(((float*)(_pureData+0))[7],otherSideIsBigEndian);
-            _tcol[2]=littleEndianFloatConversion(((float*)(_pureData+0))[8],otherSideIsBigEndian);
-            if (_tcol[0]>-5.0f)
-                tcol=_tcol; // arg is not NULL!
-
-            float* bcol=NULL;
-            float _bcol[3];
-            _bcol[0]=littleEndianFloatConversion(((float*)(_pureData+0))[9],otherSideIsBigEndian);
-            _bcol[1]=littleEndianFloatConversion(((float*)(_pureData+0))[10],otherSideIsBigEndian);
-            _bcol[2]=littleEndianFloatConversion(((float*)(_pureData+0))[11],otherSideIsBigEndian);
-            if (_bcol[0]>-5.0f)
-                bcol=_bcol; // arg is not NULL!
-
-            int handle=simAuxiliaryConsoleOpen(_cmdString.c_str(),maxLines,mode,pos,size,tcol,bcol);
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeAuxConsoleOpen(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int maxLines=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    int mode=littleEndianIntConversion(((int*)(_pureData+0))[1],otherSideIsBigEndian);
+
+    int* pos=NULL;
+    int _pos[2];
+    _pos[0]=littleEndianIntConversion(((int*)(_pureData+0))[2],otherSideIsBigEndian);
+    _pos[1]=littleEndianIntConversion(((int*)(_pureData+0))[3],otherSideIsBigEndian);
+    if (_pos[0]!=98765)
+        pos=_pos; // arg is not NULL!
+
+    int* size=NULL;
+    int _size[2];
+    _size[0]=littleEndianIntConversion(((int*)(_pureData+0))[4],otherSideIsBigEndian);
+    _size[1]=littleEndianIntConversion(((int*)(_pureData+0))[5],otherSideIsBigEndian);
+    if (_size[0]!=98765)
+        size=_size; // arg is not NULL!
+
+    float* tcol=NULL;
+    float _tcol[3];
+    _tcol[0]=littleEndianFloatConversion(((float*)(_pureData+0))[6],otherSideIsBigEndian);
+    _tcol[1]=littleEndianFloatConversion(((float*)(_pureData+0))[7],otherSideIsBigEndian);
+    _tcol[2]=littleEndianFloatConversion(((float*)(_pureData+0))[8],otherSideIsBigEndian);
+    if (_tcol[0]>-5.0f)
+        tcol=_tcol; // arg is not NULL!
+
+    float* bcol=NULL;
+    float _bcol[3];
+    _bcol[0]=littleEndianFloatConversion(((float*)(_pureData+0))[9],otherSideIsBigEndian);
+    _bcol[1]=littleEndianFloatConversion(((float*)(_pureData+0))[10],otherSideIsBigEndian);
+    _bcol[2]=littleEndianFloatConversion(((float*)(_pureData+0))[11],otherSideIsBigEndian);
+    if (_bcol[0]>-5.0f)
+        bcol=_bcol; // arg is not NULL!
+
+    int handle=simAuxiliaryConsoleOpen(_cmdString.c_str(),maxLines,mode,pos,size,tcol,bcol);
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_create_dummy:
-        {
-            float size=littleEndianFloatConversion(((float*)(_pureData+0))[0],otherSideIsBigEndian);
-            float cols[12];
-            for (int i=0;i<12;i++)
-                cols[i]=float(((unsigned char*)_pureData)[4+1+i])/255.0f;
-            float* c=NULL;
-            if (_pureData[4+0]!=0)
-                c=cols;
-            int handle=simCreateDummy(size,c);
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeCreateDummy(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    float size=littleEndianFloatConversion(((float*)(_pureData+0))[0],otherSideIsBigEndian);
+    float cols[12];
+    for (int i=0;i<12;i++)
+        cols[i]=float(((unsigned char*)_pureData)[4+1+i])/255.0f;
+    float* c=NULL;
+    if (_pureData[4+0]!=0)
+        c=cols;
+    int handle=simCreateDummy(size,c);
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_aux_console_close:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=(simAuxiliaryConsoleClose(handle)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeAuxConsoleClose(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=(simAuxiliaryConsoleClose(handle)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_aux_console_print:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success;
-            if (_pureDataSize==0)
-                success=(simAuxiliaryConsolePrint(handle,NULL)!=-1);
-            else
-                success=(simAuxiliaryConsolePrint(handle,_pureData)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeAuxConsolePrint(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success;
+    if (_pureDataSize==0)
+        success=(simAuxiliaryConsolePrint(handle,NULL)!=-1);
+    else
+        success=(simAuxiliaryConsolePrint(handle,_pureData)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_aux_console_show:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int showState=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simAuxiliaryConsoleShow(handle,showState)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeAuxConsoleShow(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int showState=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simAuxiliaryConsoleShow(handle,showState)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_vision_sensor_depth_buffer:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int res[2];
-            bool success=false;
-            if (simGetVisionSensorResolution(handle,res)!=-1)
-            {
-                char* dat=new char[4+4+res[0]*res[1]*4];
-                float* img=simGetVisionSensorDepthBuffer(handle);
-                if (img!=NULL)
-                {
-                    success=true;
-                    ((int*)(dat+0))[0]=littleEndianIntConversion(res[0],otherSideIsBigEndian);
-                    ((int*)(dat+0))[1]=littleEndianIntConversion(res[1],otherSideIsBigEndian);
-                    for (int i=0;i<res[0]*res[1];i++)
-                        ((float*)dat)[2+i]=littleEndianFloatConversion(img[i],otherSideIsBigEndian);
-                    simReleaseBuffer((simChar*)img);
-                    retCmd->setDataReply_custom_transferBuffer(dat,4+4+res[0]*res[1]*4,success);
-                }
-                else
-                    delete[] dat;
-            }
-            if (!success)
-                retCmd->setDataReply_nothing(success);
-        }
-    	break;
-
-    	case simx_cmd_get_object_orientation:
-        { // should not be used anymore, but kept for backward compatibility (10/6/2014)
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            float euler[3];
-            bool success=(simGetObjectOrientation(handle,relativeToObject,euler)!=-1);
-            // Endian conversion on the client side!
-            retCmd->setDataReply_custom_copyBuffer((char*)euler,4*3,success);
-        }
-    	break;
-
-    	case simx_cmd_get_object_position:
-        { // should not be used anymore, but kept for backward compatibility (10/6/2014)
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            float pos[3];
-            bool success=(simGetObjectPosition(handle,relativeToObject,pos)!=-1);
-            // Endian conversion on the client side!
-            retCmd->setDataReply_custom_copyBuffer((char*)pos,4*3,success);
+void CSimxCmd::_executeGetVisionSensorDepthBuffer(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res[2];
+    bool success=false;
+    if (simGetVisionSensorResolution(handle,res)!=-1)
+    {
+        float* img=simGetVisionSensorDepthBuffer(handle);
+        if (img!=NULL)
+        {
+            success=true;
+            char* dat=retCmd->_setPureDataSize(4+4+res[0]*res[1]*4);
+            ((int*)(dat+0))[0]=littleEndianIntConversion(res[0],otherSideIsBigEndian);
+            ((int*)(dat+0))[1]=littleEndianIntConversion(res[1],otherSideIsBigEndian);
+            for (int i=0;i<res[0]*res[1];i++)
+                ((float*)dat)[2+i]=littleEndianFloatConversion(img[i],otherSideIsBigEndian);
+            simReleaseBuffer((simChar*)img);
+            retCmd->_status=0;
         }
-    	break;
+    }
+    if (!success)
+        retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_object_orientation2:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            float euler[3];
-            bool success=(simGetObjectOrientation(handle,relativeToObject,euler)!=-1);
-            // Endian conversion on the client side!
-            retCmd->setDataReply_custom_copyBuffer((char*)euler,4*3,success);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectOrientation(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{ // should not be used anymore, but kept for backward compatibility (10/6/2014)
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    float euler[3];
+    bool success=(simGetObjectOrientation(handle,relativeToObject,euler)!=-1);
+    // Endian conversion on the client side!
+    retCmd->setDataReply_custom_copyBuffer((char*)euler,4*3,success);
+}
 
-    	case simx_cmd_get_object_quaternion:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            float quat[4];
-            bool success=(simGetObjectQuaternion(handle,relativeToObject,quat)!=-1);
-            // Endian conversion on the client side!
-            retCmd->setDataReply_custom_copyBuffer((char*)quat,4*4,success);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{ // should not be used anymore, but kept for backward compatibility (10/6/2014)
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    float pos[3];
+    bool success=(simGetObjectPosition(handle,relativeToObject,pos)!=-1);
+    // Endian conversion on the client side!
+    retCmd->setDataReply_custom_copyBuffer((char*)pos,4*3,success);
+}
 
-    	case simx_cmd_get_object_position2:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            float pos[3];
-            bool success=(simGetObjectPosition(handle,relativeToObject,pos)!=-1);
-            // Endian conversion on the client side!
-            retCmd->setDataReply_custom_copyBuffer((char*)pos,4*3,success);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectOrientation2(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    float euler[3];
+    bool success=(simGetObjectOrientation(handle,relativeToObject,euler)!=-1);
+    // Endian conversion on the client side!
+    retCmd->setDataReply_custom_copyBuffer((char*)euler,4*3,success);
+}
 
-    	case simx_cmd_get_object_velocity:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float data[6];
-            bool success=(simGetObjectVelocity(handle,data,data+3)!=-1);
-            // Endian conversion on the client side!
-            retCmd->setDataReply_custom_copyBuffer((char*)data,4*6,success);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectQuaternion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    float quat[4];
+    bool success=(simGetObjectQuaternion(handle,relativeToObject,quat)!=-1);
+    // Endian conversion on the client side!
+    retCmd->setDataReply_custom_copyBuffer((char*)quat,4*4,success);
+}
 
-    	case simx_cmd_set_object_orientation:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            float euler[3];
-            euler[0]=littleEndianFloatConversion(((float*)(_pureData+0))[1],otherSideIsBigEndian);
-            euler[1]=littleEndianFloatConversion(((float*)(_pureData+0))[2],otherSideIsBigEndian);
-            euler[2]=littleEndianFloatConversion(((float*)(_pureData+0))[3],otherSideIsBigEndian);
-            bool success=(simSetObjectOrientation(handle,relativeToObject,euler)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectPosition2(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    float pos[3];
+    bool success=(simGetObjectPosition(handle,relativeToObject,pos)!=-1);
+    // Endian conversion on the client side!
+    retCmd->setDataReply_custom_copyBuffer((char*)pos,4*3,success);
+}
 
-    	case simx_cmd_set_object_position:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            float pos[3];
-            pos[0]=littleEndianFloatConversion(((float*)(_pureData+0))[1],otherSideIsBigEndian);
-            pos[1]=littleEndianFloatConversion(((float*)(_pureData+0))[2],otherSideIsBigEndian);
-            pos[2]=littleEndianFloatConversion(((float*)(_pureData+0))[3],otherSideIsBigEndian);
-            bool success=(simSetObjectPosition(handle,relativeToObject,pos)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectVelocity(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float data[6];
+    bool success=(simGetObjectVelocity(handle,data,data+3)!=-1);
+    // Endian conversion on the client side!
+    retCmd->setDataReply_custom_copyBuffer((char*)data,4*6,success);
+}
 
-    	case simx_cmd_set_object_quaternion:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            float quat[4];
-            quat[0]=littleEndianFloatConversion(((float*)(_pureData+0))[1],otherSideIsBigEndian);
-            quat[1]=littleEndianFloatConversion(((float*)(_pureData+0))[2],otherSideIsBigEndian);
-            quat[2]=littleEndianFloatConversion(((float*)(_pureData+0))[3],otherSideIsBigEndian);
-            quat[3]=littleEndianFloatConversion(((float*)(_pureData+0))[4],otherSideIsBigEndian);
-            bool success=(simSetObjectQuaternion(handle,relativeToObject,quat)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetObjectOrientation(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    float euler[3];
+    euler[0]=littleEndianFloatConversion(((float*)(_pureData+0))[1],otherSideIsBigEndian);
+    euler[1]=littleEndianFloatConversion(((float*)(_pureData+0))[2],otherSideIsBigEndian);
+    euler[2]=littleEndianFloatConversion(((float*)(_pureData+0))[3],otherSideIsBigEndian);
+    bool success=(simSetObjectOrientation(handle,relativeToObject,euler)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_object_parent:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int parentObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simSetObjectParent(handle,parentObject,_pureData[4])!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetObjectPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    float pos[3];
+    pos[0]=littleEndianFloatConversion(((float*)(_pureData+0))[1],otherSideIsBigEndian);
+    pos[1]=littleEndianFloatConversion(((float*)(_pureData+0))[2],otherSideIsBigEndian);
+    pos[2]=littleEndianFloatConversion(((float*)(_pureData+0))[3],otherSideIsBigEndian);
+    bool success=(simSetObjectPosition(handle,relativeToObject,pos)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeSetObjectQuaternion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int relativeToObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    float quat[4];
+    quat[0]=littleEndianFloatConversion(((float*)(_pureData+0))[1],otherSideIsBigEndian);
+    quat[1]=littleEndianFloatConversion(((float*)(_pureData+0))[2],otherSideIsBigEndian);
+    quat[2]=littleEndianFloatConversion(((float*)(_pureData+0))[3],otherSideIsBigEndian);
+    quat[3]=littleEndianFloatConversion(((float*)(_pureData+0))[4],otherSideIsBigEndian);
+    bool success=(simSetObjectQuaternion(handle,relativeToObject,quat)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeSetObjectParent(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int parentObject=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simSetObjectParent(handle,parentObject,_pureData[4])!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_ui_button_label:
+void CSimxCmd::_executeSetUiButtonLabel(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    const char* str1=_pureData;
+    const char* str2=_pureData+strlen(_pureData)+1;
+    bool success=(simSetUIButtonLabel(handle,buttonID,str1,str2)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeGetLastErrors(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int s;
+    char* errString=sock->getAndClearFullErrorStringBuffer(s);
+    // the first 4 values represent an int that is the error string count.
+    ((int*)errString)[0]=littleEndianIntConversion(((int*)errString)[0],otherSideIsBigEndian);
+    retCmd->setDataReply_custom_transferBuffer(errString,s,true);
+}
+
+void CSimxCmd::_executeGetObjectGroupData(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int objectType=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int dataType=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    std::string retData;
+    std::vector<int> retHandles;
+    std::vector<int> retInt;
+    std::vector<float> retFloat;
+    std::string retString;
+    int retStringCount=0;
+    bool success=false;
+    std::vector<int> hand;
+
+    if ((objectType==sim_appobj_object_type)||((objectType>=sim_object_shape_type)&&(objectType<sim_object_type_end)) )
+    {
+        if (objectType==sim_appobj_object_type)
+            objectType=sim_handle_all;
+        success=true;
+        int i=0;
+        while (true)
         {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int buttonID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            const char* str1=_pureData;
-            const char* str2=_pureData+strlen(_pureData)+1;
-            bool success=(simSetUIButtonLabel(handle,buttonID,str1,str2)!=-1);
-            retCmd->setDataReply_nothing(success);
+            int handle=simGetObjects(i++,objectType);
+            if (handle<0)
+                break;
+            hand.push_back(handle);
         }
-    	break;
-
-    	case simx_cmd_get_last_errors:
+    }
+    else
+    {
+        int cnt=0;
+        int* objs=simGetCollectionObjects(objectType,&cnt);
+        if (objs!=NULL)
         {
-            int s;
-            char* errString=sock->getAndClearFullErrorStringBuffer(s);
-            // the first 4 values represent an int that is the error string count.
-            ((int*)errString)[0]=littleEndianIntConversion(((int*)errString)[0],otherSideIsBigEndian);
-            retCmd->setDataReply_custom_transferBuffer(errString,s,true);
+            success=true;
+            for (int i=0;i<cnt;i++)
+                hand.push_back(objs[i]);
+            simReleaseBuffer((char*)objs);
         }
-    	break;
+    }
 
-    	case simx_cmd_get_object_group_data:
-        {
-            int objectType=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int dataType=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            std::string retData;
-            std::vector<int> retHandles;
-            std::vector<int> retInt;
-            std::vector<float> retFloat;
-            std::string retString;
-            int retStringCount=0;
-            bool success=false;
-            std::vector<int> hand;
-
-            if ((objectType==sim_appobj_object_type)||((objectType>=sim_object_shape_type)&&(objectType<sim_object_type_end)) )
+    for (size_t i=0;i<hand.size();i++)
+    {
+        int handle=hand[i];
+        retHandles.push_back(handle);
+        if (dataType==0)
+        { // object name
+            char* name=simGetObjectName(handle);
+            retString+=name;
+            retString+='\0';
+            simReleaseBuffer(name);
+            retStringCount++;
+        }
+        if (dataType==1)
+        { // object type
+            retInt.push_back(simGetObjectType(handle));
+        }
+        if (dataType==2)
+        { // object parent
+            retInt.push_back(simGetObjectParent(handle));
+        }
+        if ((dataType==3)||(dataType==4))
+        { // object position
+            int w=-1; // abs
+            if (dataType==4)
+                w=sim_handle_parent; // rel
+            float p[3];
+            simGetObjectPosition(handle,w,p);
+            retFloat.push_back(p[0]);
+            retFloat.push_back(p[1]);
+            retFloat.push_back(p[2]);
+        }
+        if ((dataType==5)||(dataType==6))
+        { // object orientation (Euler angles)
+            int w=-1; // abs
+            if (dataType==6)
+                w=sim_handle_parent; // rel
+            float o[3];
+            simGetObjectOrientation(handle,w,o);
+            retFloat.push_back(o[0]);
+            retFloat.push_back(o[1]);
+            retFloat.push_back(o[2]);
+        }
+        if ((dataType==7)||(dataType==8))
+        { // object orientation (Quaternions)
+            int w=-1; // abs
+            if (dataType==8)
+                w=sim_handle_parent; // rel
+            float q[4];
+            simGetObjectQuaternion(handle,w,q);
+            retFloat.push_back(q[0]);
+            retFloat.push_back(q[1]);
+            retFloat.push_back(q[2]);
+            retFloat.push_back(q[3]);
+        }
+        if ((dataType==9)||(dataType==10))
+        { // object pose (position+orientation (Euler angles))
+            int w=-1; // abs
+            if (dataType==10)
+                w=sim_handle_parent; // rel
+            float p[3];
+            simGetObjectPosition(handle,w,p);
+            retFloat.push_back(p[0]);
+            retFloat.push_back(p[1]);
+            retFloat.push_back(p[2]);
+            float o[3];
+            simGetObjectOrientation(handle,w,o);
+            retFloat.push_back(o[0]);
+            retFloat.push_back(o[1]);
+            retFloat.push_back(o[2]);
+        }
+        if ((dataType==11)||(dataType==12))
+        { // object pose (position+orientation (Quaternion))
+            int w=-1; // abs
+            if (dataType==12)
+                w=sim_handle_parent; // rel
+            float p[3];
+            simGetObjectPosition(handle,w,p);
+            retFloat.push_back(p[0]);
+            retFloat.push_back(p[1]);
+            retFloat.push_back(p[2]);
+            float q[4];
+            simGetObjectOrientation(handle,w,q);
+            retFloat.push_back(q[0]);
+            retFloat.push_back(q[1]);
+            retFloat.push_back(q[2]);
+            retFloat.push_back(q[3]);
+        }
+        if (dataType==13)
+        { // prox sensor data
+            if (simGetObjectType(handle)==sim_object_proximitysensor_type)
             {
-                if (objectType==sim_appobj_object_type)
-                    objectType=sim_handle_all;
-                success=true;
-                int i=0;
-                while (true)
-                {
-                    int handle=simGetObjects(i++,objectType);
-                    if (handle<0)
-                        break;
-                    hand.push_back(handle);
-                }
+                float pt[4];
+                int obj;
+                float normal[3];
+                int res=simReadProximitySensor(handle,pt,&obj,normal);
+                retInt.push_back(res);
+                retInt.push_back(obj);
+                retFloat.push_back(pt[0]);
+                retFloat.push_back(pt[1]);
+                retFloat.push_back(pt[2]);
+                retFloat.push_back(normal[0]);
+                retFloat.push_back(normal[1]);
+                retFloat.push_back(normal[2]);
             }
             else
+            { // this is not a proximity sensor!
+                retInt.push_back(-1);
+                retInt.push_back(-1);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+            }
+        }
+        if (dataType==14)
+        { // force sensor data
+            if (simGetObjectType(handle)==sim_object_forcesensor_type)
             {
-                int cnt=0;
-                int* objs=simGetCollectionObjects(objectType,&cnt);
-                if (objs!=NULL)
-                {
-                    success=true;
-                    for (int i=0;i<cnt;i++)
-                        hand.push_back(objs[i]);
-                    simReleaseBuffer((char*)objs);
-                }
+                float force[3];
+                float torque[3];
+                int res=simReadForceSensor(handle,force,torque);
+                retInt.push_back(res);
+                retFloat.push_back(force[0]);
+                retFloat.push_back(force[1]);
+                retFloat.push_back(force[2]);
+                retFloat.push_back(torque[0]);
+                retFloat.push_back(torque[1]);
+                retFloat.push_back(torque[2]);
             }
-
-            for (size_t i=0;i<hand.size();i++)
+            else
+            { // this is not a force sensor!
+                retInt.push_back(-1);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+            }
+        }
+        if (dataType==15)
+        { // joint data
+            if (simGetObjectType(handle)==sim_object_joint_type)
             {
-                int handle=hand[i];
-                retHandles.push_back(handle);
-                if (dataType==0)
-                { // object name
-                    char* name=simGetObjectName(handle);
-                    retString+=name;
-                    retString+='\0';
-                    simReleaseBuffer(name);
-                    retStringCount++;
-                }
-                if (dataType==1)
-                { // object type
-                    retInt.push_back(simGetObjectType(handle));
-                }
-                if (dataType==2)
-                { // object parent
-                    retInt.push_back(simGetObjectParent(handle));
-                }
-                if ((dataType==3)||(dataType==4))
-                { // object position
-                    int w=-1; // abs
-                    if (dataType==4)
-                        w=sim_handle_parent; // rel
-                    float p[3];
-                    simGetObjectPosition(handle,w,p);
-                    retFloat.push_back(p[0]);
-                    retFloat.push_back(p[1]);
-                    retFloat.push_back(p[2]);
-                }
-                if ((dataType==5)||(dataType==6))
-                { // object orientation (Euler angles)
-                    int w=-1; // abs
-                    if (dataType==6)
-                        w=sim_handle_parent; // rel
-                    float o[3];
-                    simGetObjectOrientation(handle,w,o);
-                    retFloat.push_back(o[0]);
-                    retFloat.push_back(o[1]);
-                    retFloat.push_back(o[2]);
-                }
-                if ((dataType==7)||(dataType==8))
-                { // object orientation (Quaternions)
-                    int w=-1; // abs
-                    if (dataType==8)
-                        w=sim_handle_parent; // rel
-                    float q[4];
-                    simGetObjectQuaternion(handle,w,q);
-                    retFloat.push_back(q[0]);
-                    retFloat.push_back(q[1]);
-                    retFloat.push_back(q[2]);
-                    retFloat.push_back(q[3]);
-                }
-                if ((dataType==9)||(dataType==10))
-                { // object pose (position+orientation (Euler angles))
-                    int w=-1; // abs
-                    if (dataType==10)
-                        w=sim_handle_parent; // rel
-                    float p[3];
-                    simGetObjectPosition(handle,w,p);
-                    retFloat.push_back(p[0]);
-                    retFloat.push_back(p[1]);
-                    retFloat.push_back(p[2]);
-                    float o[3];
-                    simGetObjectOrientation(handle,w,o);
-                    retFloat.push_back(o[0]);
-                    retFloat.push_back(o[1]);
-                    retFloat.push_back(o[2]);
-                }
-                if ((dataType==11)||(dataType==12))
-                { // object pose (position+orientation (Quaternion))
-                    int w=-1; // abs
-                    if (dataType==12)
-                        w=sim_handle_parent; // rel
-                    float p[3];
-                    simGetObjectPosition(handle,w,p);
-                    retFloat.push_back(p[0]);
-                    retFloat.push_back(p[1]);
-                    retFloat.push_back(p[2]);
-                    float q[4];
-                    simGetObjectOrientation(handle,w,q);
-                    retFloat.push_back(q[0]);
-                    retFloat.push_back(q[1]);
-                    retFloat.push_back(q[2]);
-                    retFloat.push_back(q[3]);
-                }
-                if (dataType==13)
-                { // prox sensor data
-                    if (simGetObjectType(handle)==sim_object_proximitysensor_type)
-                    {
-                        float pt[4];
-                        int obj;
-                        float normal[3];
-                        int res=simReadProximitySensor(handle,pt,&obj,normal);
-                        retInt.push_back(res);
-                        retInt.push_back(obj);
-                        retFloat.push_back(pt[0]);
-                        retFloat.push_back(pt[1]);
-                        retFloat.push_back(pt[2]);
-                        retFloat.push_back(normal[0]);
-                        retFloat.push_back(normal[1]);
-                        retFloat.push_back(normal[2]);
-                    }
-                    else
-                    { // this is not a proximity sensor!
-                        retInt.push_back(-1);
-                        retInt.push_back(-1);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                    }
-                }
-                if (dataType==14)
-                { // force sensor data
-                    if (simGetObjectType(handle)==sim_object_forcesensor_type)
-                    {
-                        float force[3];
-                        float torque[3];
-                        int res=simReadForceSensor(handle,force,torque);
-                        retInt.push_back(res);
-                        retFloat.push_back(force[0]);
-                        retFloat.push_back(force[1]);
-                        retFloat.push_back(force[2]);
-                        retFloat.push_back(torque[0]);
-                        retFloat.push_back(torque[1]);
-                        retFloat.push_back(torque[2]);
-                    }
-                    else
-                    { // this is not a force sensor!
-                        retInt.push_back(-1);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                    }
-                }
-                if (dataType==15)
-                { // joint data
-                    if (simGetObjectType(handle)==sim_object_joint_type)
-                    {
-                        float pos=0.0f;
-                        float force=0.0f;
-                        simGetJointPosition(handle,&pos);
-                        simJointGetForce(handle,&force);
-                        retFloat.push_back(pos);
-                        retFloat.push_back(force);
-                    }
-                    else
-                    { // this is not a joint!
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                    }
-                }
-                if (dataType==16)
-                { // joint type, mode and limit data
-                    if (simGetObjectType(handle)==sim_object_joint_type)
-                    {
-                        float range[2];
-                        simBool cyclic;
-                        simGetJointInterval(handle,&cyclic,range);
-                        if (cyclic)
-                            range[1]=-1.0f;
-                        int jointType=simGetJointType(handle);
-                        int options;
-                        int jointMode=simGetJointMode(handle,&options);
-                        if (options&1)
-                            jointMode|=65536;
-                        retInt.push_back(jointType);
-                        retInt.push_back(jointMode);
-                        retFloat.push_back(range[0]);
-                        retFloat.push_back(range[1]);
-                    }
-                    else
-                    { // this is not a joint!
-                        retInt.push_back(-1);
-                        retInt.push_back(-1);
-                        retFloat.push_back(0.0f);
-                        retFloat.push_back(0.0f);
-                    }
-                }
-                if (dataType==17)
-                { // object linear velocity
-                    float linVel[3];
-                    simGetObjectVelocity(handle,linVel,NULL);
-                    retFloat.push_back(linVel[0]);
-                    retFloat.push_back(linVel[1]);
-                    retFloat.push_back(linVel[2]);
-                }
-                if (dataType==18)
-                { // object angular velocity
-                    float angVel[3];
-                    simGetObjectVelocity(handle,NULL,angVel);
-                    retFloat.push_back(angVel[0]);
-                    retFloat.push_back(angVel[1]);
-                    retFloat.push_back(angVel[2]);
-                }
-                if (dataType==19)
-                { // object linear and angular velocity (twist data)
-                    float linVel[3];
-                    float angVel[3];
-                    simGetObjectVelocity(handle,linVel,angVel);
-                    retFloat.push_back(linVel[0]);
-                    retFloat.push_back(linVel[1]);
-                    retFloat.push_back(linVel[2]);
-                    retFloat.push_back(angVel[0]);
-                    retFloat.push_back(angVel[1]);
-                    retFloat.push_back(angVel[2]);
-                }
-            }
-
-            if (success)
-            {
-                appendIntToString(retData,int(retHandles.size()),false,otherSideIsBigEndian);
-                appendIntToString(retData,int(retInt.size()),false,otherSideIsBigEndian);
-                appendIntToString(retData,int(retFloat.size()),false,otherSideIsBigEndian);
-                appendIntToString(retData,retStringCount,false,otherSideIsBigEndian);
-                for (int i=0;i<int(retHandles.size());i++)
-                    appendIntToString(retData,retHandles[i],true,otherSideIsBigEndian);
-                for (int i=0;i<int(retInt.size());i++)
-                    appendIntToString(retData,retInt[i],true,otherSideIsBigEndian);
-                for (int i=0;i<int(retFloat.size());i++)
-                    appendFloatToString(retData,retFloat[i],true,otherSideIsBigEndian);
-                retData+=retString;
-                retCmd->setDataReply_custom_copyBuffer(&retData[0],int(retData.length()),success);
+                float pos=0.0f;
+                float force=0.0f;
+                simGetJointPosition(handle,&pos);
+                simJointGetForce(handle,&force);
+                retFloat.push_back(pos);
+                retFloat.push_back(force);
             }
             else
-                retCmd->setDataReply_nothing(false);
+            { // this is not a joint!
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+            }
         }
-    	break;
-
-    	case simx_cmd_call_script_function:
-        {
-            int options=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            std::string scriptDescription(_cmdString);
-            std::string functionName(_cmdString2);
-            std::vector<int> inInt;
-            std::vector<float> inFloat;
-            std::vector<std::string> inString;
-
-            int inIntCnt=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            int inFloatCnt=littleEndianIntConversion(((int*)(_pureData+4))[0],otherSideIsBigEndian);
-            int inStringCnt=littleEndianIntConversion(((int*)(_pureData+8))[0],otherSideIsBigEndian);
-            int inBufferSize=littleEndianIntConversion(((int*)(_pureData+12))[0],otherSideIsBigEndian);
-            int off=4*4;
-
-            for (int i=0;i<inIntCnt;i++)
-                inInt.push_back(littleEndianIntConversion(((int*)(_pureData+off))[i],otherSideIsBigEndian));
-            off+=inIntCnt*4;
-
-            for (int i=0;i<inFloatCnt;i++)
-                inFloat.push_back(littleEndianFloatConversion(((float*)(_pureData+off))[i],otherSideIsBigEndian));
-            off+=inFloatCnt*4;
-
-            int totStringL=0;
-            for (int i=0;i<inStringCnt;i++)
+        if (dataType==16)
+        { // joint type, mode and limit data
+            if (simGetObjectType(handle)==sim_object_joint_type)
             {
-                inString.push_back(_pureData+off+totStringL);
-                totStringL+=int(strlen(_pureData+off+totStringL)+1);
+                float range[2];
+                simBool cyclic;
+                simGetJointInterval(handle,&cyclic,range);
+                if (cyclic)
+                    range[1]=-1.0f;
+                int jointType=simGetJointType(handle);
+                int options;
+                int jointMode=simGetJointMode(handle,&options);
+                if (options&1)
+                    jointMode|=65536;
+                retInt.push_back(jointType);
+                retInt.push_back(jointMode);
+                retFloat.push_back(range[0]);
+                retFloat.push_back(range[1]);
             }
-            off+=totStringL;
-
-            CScriptFunctionData D;
-            D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(inInt));
-            D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(inFloat));
-            D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(inString));
-            if (inBufferSize>0)
-                D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(_pureData+off,inBufferSize));
             else
-                D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(0,0));
-            int stack=simCreateStack();
-            D.writeDataToStack_scriptFunctionCall(stack);
+            { // this is not a joint!
+                retInt.push_back(-1);
+                retInt.push_back(-1);
+                retFloat.push_back(0.0f);
+                retFloat.push_back(0.0f);
+            }
+        }
+        if (dataType==17)
+        { // object linear velocity
+            float linVel[3];
+            simGetObjectVelocity(handle,linVel,NULL);
+            retFloat.push_back(linVel[0]);
+            retFloat.push_back(linVel[1]);
+            retFloat.push_back(linVel[2]);
+        }
+        if (dataType==18)
+        { // object angular velocity
+            float angVel[3];
+            simGetObjectVelocity(handle,NULL,angVel);
+            retFloat.push_back(angVel[0]);
+            retFloat.push_back(angVel[1]);
+            retFloat.push_back(angVel[2]);
+        }
+        if (dataType==19)
+        { // object linear and angular velocity (twist data)
+            float linVel[3];
+            float angVel[3];
+            simGetObjectVelocity(handle,linVel,angVel);
+            retFloat.push_back(linVel[0]);
+            retFloat.push_back(linVel[1]);
+            retFloat.push_back(linVel[2]);
+            retFloat.push_back(angVel[0]);
+            retFloat.push_back(angVel[1]);
+            retFloat.push_back(angVel[2]);
+        }
+    }
 
-            bool success=false;
+    if (success)
+    {
+        appendIntToString(retData,int(retHandles.size()),false,otherSideIsBigEndian);
+        appendIntToString(retData,int(retInt.size()),false,otherSideIsBigEndian);
+        appendIntToString(retData,int(retFloat.size()),false,otherSideIsBigEndian);
+        appendIntToString(retData,retStringCount,false,otherSideIsBigEndian);
+        for (int i=0;i<int(retHandles.size());i++)
+            appendIntToString(retData,retHandles[i],true,otherSideIsBigEndian);
+        for (int i=0;i<int(retInt.size());i++)
+            appendIntToString(retData,retInt[i],true,otherSideIsBigEndian);
+        for (int i=0;i<int(retFloat.size());i++)
+            appendFloatToString(retData,retFloat[i],true,otherSideIsBigEndian);
+        retData+=retString;
+        retCmd->setDataReply_custom_copyBuffer(&retData[0],int(retData.length()),success);
+    }
+    else
+        retCmd->setDataReply_nothing(false);
+}
 
-            if (scriptDescription.length()>0)
-            {
-                functionName+='@';
-                functionName+=scriptDescription;
-            }
+void CSimxCmd::_executeCallScriptFunction(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int options=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    std::string scriptDescription(_cmdString);
+    std::string functionName(_cmdString2);
+    std::vector<int> inInt;
+    std::vector<float> inFloat;
+    std::vector<std::string> inString;
+
+    int inIntCnt=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    int inFloatCnt=littleEndianIntConversion(((int*)(_pureData+4))[0],otherSideIsBigEndian);
+    int inStringCnt=littleEndianIntConversion(((int*)(_pureData+8))[0],otherSideIsBigEndian);
+    int inBufferSize=littleEndianIntConversion(((int*)(_pureData+12))[0],otherSideIsBigEndian);
+    int off=4*4;
+
+    for (int i=0;i<inIntCnt;i++)
+        inInt.push_back(littleEndianIntConversion(((int*)(_pureData+off))[i],otherSideIsBigEndian));
+    off+=inIntCnt*4;
+
+    for (int i=0;i<inFloatCnt;i++)
+        inFloat.push_back(littleEndianFloatConversion(((float*)(_pureData+off))[i],otherSideIsBigEndian));
+    off+=inFloatCnt*4;
+
+    int totStringL=0;
+    for (int i=0;i<inStringCnt;i++)
+    {
+        inString.push_back(_pureData+off+totStringL);
+        totStringL+=int(strlen(_pureData+off+totStringL)+1);
+    }
+    off+=totStringL;
+
+    CScriptFunctionData D;
+    D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(inInt));
+    D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(inFloat));
+    D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(inString));
+    if (inBufferSize>0)
+        D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(_pureData+off,inBufferSize));
+    else
+        D.pushOutData_scriptFunctionCall(CScriptFunctionDataItem(0,0));
+    int stack=simCreateStack();
+    D.writeDataToStack_scriptFunctionCall(stack);
 
-            if (simCallScriptFunctionEx(options,functionName.c_str(),stack)!=-1)
-            { // success!
-                // Now check the return arguments:
-                const int outArgs[]={4,sim_script_arg_int32|sim_script_arg_table,0,sim_script_arg_float|sim_script_arg_table,0,sim_script_arg_string|sim_script_arg_table,0,sim_script_arg_charbuff,0};
+    bool success=false;
 
-                if (D.readDataFromStack_scriptFunctionCall(stack,outArgs,outArgs[0],functionName.c_str()))
-                {
-                    std::vector<CScriptFunctionDataItem>* outData=D.getOutDataPtr_scriptFunctionCall();
-                    int outIntCnt=(int)outData->at(0).int32Data.size();
-                    int outFloatCnt=(int)outData->at(1).floatData.size();
-                    int outStringCnt=(int)outData->at(2).stringData.size();
-                    int outBufferSize=(int)outData->at(3).stringData[0].size();
-                    std::string retData;
-                    appendIntToString(retData,outIntCnt,false,otherSideIsBigEndian);
-                    appendIntToString(retData,outFloatCnt,false,otherSideIsBigEndian);
-                    appendIntToString(retData,outStringCnt,false,otherSideIsBigEndian);
-                    appendIntToString(retData,outBufferSize,false,otherSideIsBigEndian);
-                    for (int i=0;i<outIntCnt;i++)
-                        appendIntToString(retData,outData->at(0).int32Data[i],true,otherSideIsBigEndian);
-                    for (int i=0;i<outFloatCnt;i++)
-                        appendFloatToString(retData,outData->at(1).floatData[i],true,otherSideIsBigEndian);
-                    for (int i=0;i<outStringCnt;i++)
-                    {
-                        retData+=std::string(outData->at(2).stringData[i].c_str()); // make sure we don't have embedded zeros, otherwise trouble!
-                        retData+='\0';
-                    }
-                    retData+=outData->at(3).stringData[0];
-                    retCmd->setDataReply_custom_copyBuffer(&retData[0],int(retData.length()),true);
-                    success=true;
-                }
-                else
-                {
-                    functionName="simCallScriptFunctionEx on "+functionName;
-                    simSetLastError(functionName.c_str(),"Function didn't produce expected return values, i.e. an int table, a float table, a string table and a buffer string.");
-                }
-            }
-            else
-            {
-                functionName="simCallScriptFunctionEx on "+functionName;
-                simSetLastError(functionName.c_str(),"Call failed.");
-            }
-            simReleaseStack(stack);
+    if (scriptDescription.length()>0)
+    {
+        functionName+='@';
+        functionName+=scriptDescription;
+    }
 
-            if (!success)
-                retCmd->setDataReply_nothing(false);
-        }
-    	break;
+    if (simCallScriptFunctionEx(options,functionName.c_str(),stack)!=-1)
+    { // success!
+        // Now check the return arguments:
+        const int outArgs[]={4,sim_script_arg_int32|sim_script_arg_table,0,sim_script_arg_float|sim_script_arg_table,0,sim_script_arg_string|sim_script_arg_table,0,sim_script_arg_charbuff,0};
 
-    	case simx_cmd_get_array_parameter:
+        if (D.readDataFromStack_scriptFunctionCall(stack,outArgs,outArgs[0],functionName.c_str()))
         {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float p[3];
-            bool success=(simGetArrayParameter(parameterID,p)!=-1);
-            if (success)
+            std::vector<CScriptFunctionDataItem>* outData=D.getOutDataPtr_scriptFunctionCall();
+            int outIntCnt=(int)outData->at(0).int32Data.size();
+            int outFloatCnt=(int)outData->at(1).floatData.size();
+            int outStringCnt=(int)outData->at(2).stringData.size();
+            int outBufferSize=(int)outData->at(3).stringData[0].size();
+            std::string retData;
+            appendIntToString(retData,outIntCnt,false,otherSideIsBigEndian);
+            appendIntToString(retData,outFloatCnt,false,otherSideIsBigEndian);
+            appendIntToString(retData,outStringCnt,false,otherSideIsBigEndian);
+            appendIntToString(retData,outBufferSize,false,otherSideIsBigEndian);
+            for (int i=0;i<outIntCnt;i++)
+                appendIntToString(retData,outData->at(0).int32Data[i],true,otherSideIsBigEndian);
+            for (int i=0;i<outFloatCnt;i++)
+                appendFloatToString(retData,outData->at(1).floatData[i],true,otherSideIsBigEndian);
+            for (int i=0;i<outStringCnt;i++)
             {
-                p[0]=littleEndianFloatConversion(p[0],otherSideIsBigEndian);
-                p[1]=littleEndianFloatConversion(p[1],otherSideIsBigEndian);
-                p[2]=littleEndianFloatConversion(p[2],otherSideIsBigEndian);
+                retData+=std::string(outData->at(2).stringData[i].c_str()); // make sure we don't have embedded zeros, otherwise trouble!
+                retData+='\0';
             }
-            retCmd->setDataReply_custom_copyBuffer((char*)p,3*4,success);
+            retData+=outData->at(3).stringData[0];
+            retCmd->setDataReply_custom_copyBuffer(&retData[0],int(retData.length()),true);
+            success=true;
         }
-    	break;
-
-    	case simx_cmd_set_array_parameter:
+        else
         {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float p[3];
-            p[0]=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
-            p[1]=littleEndianFloatConversion(((float*)_pureData)[1],otherSideIsBigEndian);
-            p[2]=littleEndianFloatConversion(((float*)_pureData)[2],otherSideIsBigEndian);
-            bool success=(simSetArrayParameter(parameterID,p)!=-1);
-            retCmd->setDataReply_nothing(success);
+            functionName="simCallScriptFunctionEx on "+functionName;
+            simSetLastError(functionName.c_str(),"Function didn't produce expected return values, i.e. an int table, a float table, a string table and a buffer string.");
         }
-    	break;
+    }
+    else
+    {
+        functionName="simCallScriptFunctionEx on "+functionName;
+        simSetLastError(functionName.c_str(),"Call failed.");
+    }
+    simReleaseStack(stack);
 
-    	case simx_cmd_get_boolean_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int p=simGetBooleanParameter(parameterID);
-            bool success=(p!=-1);
-            retCmd->setDataReply_1int(p,success,otherSideIsBigEndian);
-        }
-    	break;
+    if (!success)
+        retCmd->setDataReply_nothing(false);
+}
 
-    	case simx_cmd_set_boolean_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int p=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetBooleanParameter(parameterID,p)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetArrayParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float p[3];
+    bool success=(simGetArrayParameter(parameterID,p)!=-1);
+    if (success)
+    {
+        p[0]=littleEndianFloatConversion(p[0],otherSideIsBigEndian);
+        p[1]=littleEndianFloatConversion(p[1],otherSideIsBigEndian);
+        p[2]=littleEndianFloatConversion(p[2],otherSideIsBigEndian);
+    }
+    retCmd->setDataReply_custom_copyBuffer((char*)p,3*4,success);
+}
 
-    	case simx_cmd_get_integer_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int p;
-            bool success=(simGetIntegerParameter(parameterID,&p)!=-1);
-            retCmd->setDataReply_1int(p,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeSetArrayParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float p[3];
+    p[0]=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
+    p[1]=littleEndianFloatConversion(((float*)_pureData)[1],otherSideIsBigEndian);
+    p[2]=littleEndianFloatConversion(((float*)_pureData)[2],otherSideIsBigEndian);
+    bool success=(simSetArrayParameter(parameterID,p)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_integer_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int p=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetIntegerParameter(parameterID,p)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetBooleanParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int p=simGetBooleanParameter(parameterID);
+    bool success=(p!=-1);
+    retCmd->setDataReply_1int(p,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_floating_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float p;
-            bool success=(simGetFloatingParameter(parameterID,&p)!=-1);
-            retCmd->setDataReply_1float(p,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeSetBooleanParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int p=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetBooleanParameter(parameterID,p)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_floating_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float p=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
-            bool success=(simSetFloatingParameter(parameterID,p)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetIntegerParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int p;
+    bool success=(simGetIntegerParameter(parameterID,&p)!=-1);
+    retCmd->setDataReply_1int(p,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_string_parameter:
-        {
-            int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            char* str=simGetStringParameter(parameterID);
-            if (str!=NULL)
-            {
-                retCmd->setDataReply_custom_copyBuffer(str,int(strlen(str)+1),true);
-                simReleaseBuffer(str);
-            }
-            else
-                retCmd->setDataReply_nothing(false);
-        }
-    	break;
+void CSimxCmd::_executeSetIntegerParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int p=littleEndianIntConversion(((int*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetIntegerParameter(parameterID,p)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_collision_handle:
-        {
-            int handle=simGetCollisionHandle(_cmdString.c_str());
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetFloatingParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float p;
+    bool success=(simGetFloatingParameter(parameterID,&p)!=-1);
+    retCmd->setDataReply_1float(p,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_get_distance_handle:
-        {
-            int handle=simGetDistanceHandle(_cmdString.c_str());
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeSetFloatingParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float p=littleEndianFloatConversion(((float*)_pureData)[0],otherSideIsBigEndian);
+    bool success=(simSetFloatingParameter(parameterID,p)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_collection_handle:
-        {
-            int handle=simGetCollectionHandle(_cmdString.c_str());
-            bool success=(handle!=-1);
-            retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetStringParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int parameterID=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    char* str=simGetStringParameter(parameterID);
+    if (str!=NULL)
+    {
+        retCmd->setDataReply_custom_copyBuffer(str,int(strlen(str)+1),true);
+        simReleaseBuffer(str);
+    }
+    else
+        retCmd->setDataReply_nothing(false);
+}
 
-    	case simx_cmd_read_collision:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int res=simReadCollision(handle);
-            bool success=(res!=-1);
-            retCmd->setDataReply_1int(res,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetCollisionHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=simGetCollisionHandle(_cmdString.c_str());
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_read_distance:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            float dist=0.0f;
-            bool success=(simReadDistance(handle,&dist)!=-1);
-            retCmd->setDataReply_1float(dist,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetDistanceHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=simGetDistanceHandle(_cmdString.c_str());
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_remove_object:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=(simRemoveObject(handle)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetCollectionHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=simGetCollectionHandle(_cmdString.c_str());
+    bool success=(handle!=-1);
+    retCmd->setDataReply_1int(handle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_remove_model:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=(simRemoveModel(handle)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeReadCollision(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res=simReadCollision(handle);
+    bool success=(res!=-1);
+    retCmd->setDataReply_1int(res,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_remove_ui:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=(simRemoveUI(handle)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeReadDistance(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    float dist=0.0f;
+    bool success=(simReadDistance(handle,&dist)!=-1);
+    retCmd->setDataReply_1float(dist,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_close_scene:
-        {
-            int res=simCloseScene();
-            retCmd->setDataReply_nothing(res!=-1);
-        }
-    	break;
+void CSimxCmd::_executeRemoveObject(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=(simRemoveObject(handle)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_objects:
-        {
-            int objType=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int index=0;
-            std::vector<int> handles;
-            while (true)
-            {
-                int h=simGetObjects(index++,objType);
-                if (h==-1)
-                    break;
-                handles.push_back(h);
-            }
-            char* buff=new char[4+handles.size()*4];
-            ((int*)buff)[0]=littleEndianIntConversion(int(handles.size()),otherSideIsBigEndian);
-            for (unsigned int i=0;i<handles.size();i++)
-                ((int*)buff)[1+i]=littleEndianIntConversion(handles[i],otherSideIsBigEndian);
-            retCmd->setDataReply_custom_transferBuffer(buff,4+int(handles.size())*4,true);
-        }
-    	break;
+void CSimxCmd::_executeRemoveModel(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=(simRemoveModel(handle)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_display_dialog:
-        {
-            char* mainText=_pureData+0;
-            int off=int(strlen(mainText))+1;
-            int dlgType=littleEndianIntConversion(((int*)(_pureData+off))[0],otherSideIsBigEndian);
-            off+=4;
-            char* initialText=_pureData+off;
-            off+=int(strlen(initialText))+1;
-
-            float* col1=NULL;
-            float _col1[6];
-            for (int i=0;i<6;i++)
-                _col1[i]=littleEndianFloatConversion(((float*)(_pureData+off))[i],otherSideIsBigEndian);
-            if (_col1[0]>-5.0f)
-                col1=_col1; // arg is not NULL!
-            off+=6*4;
-
-            float* col2=NULL;
-            float _col2[6];
-            for (int i=0;i<6;i++)
-                _col2[i]=littleEndianFloatConversion(((float*)(_pureData+off))[i],otherSideIsBigEndian);
-            if (_col2[0]>-5.0f)
-                col2=_col2; // arg is not NULL!
-            off+=6*4;
-
-            int uiHandle;
-            int handle=simDisplayDialog(_cmdString.c_str(),mainText,dlgType,initialText,col1,col2,&uiHandle);
-            bool success=(handle!=-1);
-            retCmd->setDataReply_2int(handle,uiHandle,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeRemoveUi(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=(simRemoveUI(handle)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_end_dialog:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            bool success=(simEndDialog(handle)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeCloseScene(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int res=simCloseScene();
+    retCmd->setDataReply_nothing(res!=-1);
+}
 
-    	case simx_cmd_get_dialog_result:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int result=simGetDialogResult(handle);
-            retCmd->setDataReply_1int(result,result!=-1,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeGetObjects(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int objType=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int index=0;
+    std::vector<int> handles;
+    while (true)
+    {
+        int h=simGetObjects(index++,objType);
+        if (h==-1)
+            break;
+        handles.push_back(h);
+    }
+    char* buff=retCmd->_setPureDataSize(4+int(handles.size())*4);
+    ((int*)buff)[0]=littleEndianIntConversion(int(handles.size()),otherSideIsBigEndian);
+    for (unsigned int i=0;i<handles.size();i++)
+        ((int*)buff)[1+i]=littleEndianIntConversion(handles[i],otherSideIsBigEndian);
+    retCmd->_status=0;
+}
 
-    	case simx_cmd_get_dialog_input:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            char* input=simGetDialogInput(handle);
-            if (input!=NULL)
-            {
-                retCmd->setDataReply_custom_copyBuffer(input,int(strlen(input))+1,true);
-                simReleaseBuffer(input);
-            }
-            else
-                retCmd->setDataReply_nothing(false);
-        }
-    	break;
+void CSimxCmd::_executeDisplayDialog(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    char* mainText=_pureData+0;
+    int off=int(strlen(mainText))+1;
+    int dlgType=littleEndianIntConversion(((int*)(_pureData+off))[0],otherSideIsBigEndian);
+    off+=4;
+    char* initialText=_pureData+off;
+    off+=int(strlen(initialText))+1;
+
+    float* col1=NULL;
+    float _col1[6];
+    for (int i=0;i<6;i++)
+        _col1[i]=littleEndianFloatConversion(((float*)(_pureData+off))[i],otherSideIsBigEndian);
+    if (_col1[0]>-5.0f)
+        col1=_col1; // arg is not NULL!
+    off+=6*4;
+
+    float* col2=NULL;
+    float _col2[6];
+    for (int i=0;i<6;i++)
+        _col2[i]=littleEndianFloatConversion(((float*)(_pureData+off))[i],otherSideIsBigEndian);
+    if (_col2[0]>-5.0f)
+        col2=_col2; // arg is not NULL!
+    off+=6*4;
+
+    int uiHandle;
+    int handle=simDisplayDialog(_cmdString.c_str(),mainText,dlgType,initialText,col1,col2,&uiHandle);
+    bool success=(handle!=-1);
+    retCmd->setDataReply_2int(handle,uiHandle,success,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_copy_paste_objects:
-        {
-            // 1. Save current selection state:
-            int initialSelSize=simGetObjectSelectionSize();
-            int* initialSelection=new int[initialSelSize];
-            simGetObjectSelection(initialSelection);
-            simRemoveObjectFromSelection(sim_handle_all,0);
-
-            // 2. Select objects we wanna copy and paste:
-            int cnt=_pureDataSize/4;
-            for (int i=0;i<cnt;i++)
-                simAddObjectToSelection(sim_handle_single,littleEndianIntConversion(((int*)(_pureData+0))[i],otherSideIsBigEndian));
-
-            // 3. Copy and paste the selection:
-            simCopyPasteSelectedObjects();
-
-            // 4. Send back the handles of the new objects:
-            int newSelSize=simGetObjectSelectionSize();
-            int* newSelection=new int[newSelSize+1];
-            simGetObjectSelection(newSelection+1);
-            newSelection[0]=littleEndianIntConversion(newSelSize,otherSideIsBigEndian);
-            for (int i=0;i<newSelSize;i++)
-                newSelection[1+i]=littleEndianIntConversion(newSelection[1+i],otherSideIsBigEndian);
-            retCmd->setDataReply_custom_transferBuffer((char*)newSelection,(newSelSize+1)*4,true);
-
-            // 4. Restore previous selection state
-            simRemoveObjectFromSelection(sim_handle_all,0);
-            for (int i=0;i<initialSelSize;i++)
-                simAddObjectToSelection(sim_handle_single,initialSelection[i]);
-            delete[] initialSelection;
-        }
-    	break;
+void CSimxCmd::_executeEndDialog(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    bool success=(simEndDialog(handle)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_object_selection:
-        {
-            int newSelSize=simGetObjectSelectionSize();
-            int* newSelection=new int[newSelSize+1];
-            simGetObjectSelection(newSelection+1);
-            newSelection[0]=littleEndianIntConversion(newSelSize,otherSideIsBigEndian);
-            for (int i=0;i<newSelSize;i++)
-                newSelection[1+i]=littleEndianIntConversion(newSelection[1+i],otherSideIsBigEndian);
-            retCmd->setDataReply_custom_transferBuffer((char*)newSelection,(newSelSize+1)*4,true);
-        }
-    	break;
+void CSimxCmd::_executeGetDialogResult(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int result=simGetDialogResult(handle);
+    retCmd->setDataReply_1int(result,result!=-1,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_object_selection:
-        {
-            simRemoveObjectFromSelection(sim_handle_all,0);
-            int cnt=_pureDataSize/4;
-            for (int i=0;i<cnt;i++)
-                simAddObjectToSelection(sim_handle_single,littleEndianIntConversion(((int*)(_pureData+0))[i],otherSideIsBigEndian));
-            retCmd->setDataReply_nothing(true);
-        }
-    	break;
+void CSimxCmd::_executeGetDialogInput(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    char* input=simGetDialogInput(handle);
+    if (input!=NULL)
+    {
+        retCmd->setDataReply_custom_copyBuffer(input,int(strlen(input))+1,true);
+        simReleaseBuffer(input);
+    }
+    else
+        retCmd->setDataReply_nothing(false);
+}
 
-    	case simx_cmd_clear_float_signal:
-        {
-            int res;
-            if (_cmdString.length()==0)
-                res=simClearFloatSignal(NULL);
-            else
-                res=simClearFloatSignal(_cmdString.c_str());
-            retCmd->setDataReply_nothing(res!=-1);
-        }
-    	break;
+void CSimxCmd::_executeCopyPasteObjects(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    // 1. Save current selection state:
+    int initialSelSize=simGetObjectSelectionSize();
+    int* initialSelection=new int[initialSelSize];
+    simGetObjectSelection(initialSelection);
+    simRemoveObjectFromSelection(sim_handle_all,0);
+
+    // 2. Select objects we wanna copy and paste:
+    int cnt=_pureDataSize/4;
+    for (int i=0;i<cnt;i++)
+        simAddObjectToSelection(sim_handle_single,littleEndianIntConversion(((int*)(_pureData+0))[i],otherSideIsBigEndian));
+
+    // 3. Copy and paste the selection:
+    simCopyPasteSelectedObjects();
+
+    // 4. Send back the handles of the new objects:
+    int newSelSize=simGetObjectSelectionSize();
+    int* newSelection=new int[newSelSize+1];
+    simGetObjectSelection(newSelection+1);
+    newSelection[0]=littleEndianIntConversion(newSelSize,otherSideIsBigEndian);
+    for (int i=0;i<newSelSize;i++)
+        newSelection[1+i]=littleEndianIntConversion(newSelection[1+i],otherSideIsBigEndian);
+    retCmd->setDataReply_custom_transferBuffer((char*)newSelection,(newSelSize+1)*4,true);
+
+    // 4. Restore previous selection state
+    simRemoveObjectFromSelection(sim_handle_all,0);
+    for (int i=0;i<initialSelSize;i++)
+        simAddObjectToSelection(sim_handle_single,initialSelection[i]);
+    delete[] initialSelection;
+}
 
-    	case simx_cmd_clear_integer_signal:
-        {
-            int res;
-            if (_cmdString.length()==0)
-                res=simClearIntegerSignal(NULL);
-            else
-                res=simClearIntegerSignal(_cmdString.c_str());
-            retCmd->setDataReply_nothing(res!=-1);
-        }
-    	break;
+void CSimxCmd::_executeGetObjectSelection(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int newSelSize=simGetObjectSelectionSize();
+    int* newSelection=new int[newSelSize+1];
+    simGetObjectSelection(newSelection+1);
+    newSelection[0]=littleEndianIntConversion(newSelSize,otherSideIsBigEndian);
+    for (int i=0;i<newSelSize;i++)
+        newSelection[1+i]=littleEndianIntConversion(newSelection[1+i],otherSideIsBigEndian);
+    retCmd->setDataReply_custom_transferBuffer((char*)newSelection,(newSelSize+1)*4,true);
+}
 
-    	case simx_cmd_clear_string_signal:
-        {
-            int res;
-            if (_cmdString.length()==0)
-                res=simClearStringSignal(NULL);
-            else
-                res=simClearStringSignal(_cmdString.c_str());
-            retCmd->setDataReply_nothing(res!=-1);
-        }
-    	break;
+void CSimxCmd::_executeSetObjectSelection(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    simRemoveObjectFromSelection(sim_handle_all,0);
+    int cnt=_pureDataSize/4;
+    for (int i=0;i<cnt;i++)
+        simAddObjectToSelection(sim_handle_single,littleEndianIntConversion(((int*)(_pureData+0))[i],otherSideIsBigEndian));
+    retCmd->setDataReply_nothing(true);
+}
 
-    	case simx_cmd_get_float_signal:
-        {
-            float signalValue;
-            int res=simGetFloatSignal(_cmdString.c_str(),&signalValue);
-            retCmd->setDataReply_1float(signalValue,res>0,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeClearFloatSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int res;
+    if (_cmdString.length()==0)
+        res=simClearFloatSignal(NULL);
+    else
+        res=simClearFloatSignal(_cmdString.c_str());
+    retCmd->setDataReply_nothing(res!=-1);
+}
 
-    	case simx_cmd_get_integer_signal:
-        {
-            int signalValue;
-            int res=simGetIntegerSignal(_cmdString.c_str(),&signalValue);
-            retCmd->setDataReply_1int(signalValue,res>0,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeClearIntegerSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int res;
+    if (_cmdString.length()==0)
+        res=simClearIntegerSignal(NULL);
+    else
+        res=simClearIntegerSignal(_cmdString.c_str());
+    retCmd->setDataReply_nothing(res!=-1);
+}
 
-    	case simx_cmd_get_string_signal:
-        {
-            int signalLength;
-            char* signalValue=simGetStringSignal(_cmdString.c_str(),&signalLength);
-            if (signalValue!=NULL)
-            {
-                retCmd->setDataReply_custom_copyBuffer(signalValue,signalLength,true);
-                simReleaseBuffer(signalValue);
-            }
-            else
-                retCmd->setDataReply_nothing(false);
-        }
-    	break;
+void CSimxCmd::_executeClearStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int res;
+    if (_cmdString.length()==0)
+        res=simClearStringSignal(NULL);
+    else
+        res=simClearStringSignal(_cmdString.c_str());
+    retCmd->setDataReply_nothing(res!=-1);
+}
 
-    	case simx_cmd_get_and_clear_string_signal:
-        {
-            int signalLength;
-            char* signalValue=simGetStringSignal(_cmdString.c_str(),&signalLength);
-            if (signalValue!=NULL)
-            {
-                retCmd->setDataReply_custom_copyBuffer(signalValue,signalLength,true);
-                simReleaseBuffer(signalValue);
-                simClearStringSignal(_cmdString.c_str());
-                _opMode=simx_opmode_oneshot; // We need to remove this command! (this is a special case, only for this command. See the doc!)
-            }
-            else
-                retCmd->setDataReply_nothing(false);
-        }
-    	break;
+void CSimxCmd::_executeGetFloatSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    float signalValue;
+    int res=simGetFloatSignal(_cmdString.c_str(),&signalValue);
+    retCmd->setDataReply_1float(signalValue,res>0,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_read_string_stream:
-        {
-            int signalLength;
-            char* signalValue=simGetStringSignal(_cmdString.c_str(),&signalLength);
-            if (signalValue!=NULL)
-            {
-                retCmd->setDataReply_custom_copyBuffer(signalValue,signalLength,true);
-                simReleaseBuffer(signalValue);
-                simClearStringSignal(_cmdString.c_str());
-            }
-            else
-                retCmd->setDataReply_nothing(true);
-        }
-    	break;
+void CSimxCmd::_executeGetIntegerSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int signalValue;
+    int res=simGetIntegerSignal(_cmdString.c_str(),&signalValue);
+    retCmd->setDataReply_1int(signalValue,res>0,otherSideIsBigEndian);
+}
 
-    	case simx_cmd_set_float_signal:
-        {
-            float signalValue=littleEndianFloatConversion(((float*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simSetFloatSignal(_cmdString.c_str(),signalValue)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int signalLength;
+    char* signalValue=simGetStringSignal(_cmdString.c_str(),&signalLength);
+    if (signalValue!=NULL)
+    {
+        retCmd->setDataReply_custom_copyBuffer(signalValue,signalLength,true);
+        simReleaseBuffer(signalValue);
+    }
+    else
+        retCmd->setDataReply_nothing(false);
+}
 
-    	case simx_cmd_set_integer_signal:
-        {
-            int signalValue=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simSetIntegerSignal(_cmdString.c_str(),signalValue)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeGetAndClearStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int signalLength;
+    char* signalValue=simGetStringSignal(_cmdString.c_str(),&signalLength);
+    if (signalValue!=NULL)
+    {
+        retCmd->setDataReply_custom_copyBuffer(signalValue,signalLength,true);
+        simReleaseBuffer(signalValue);
+        simClearStringSignal(_cmdString.c_str());
+        _opMode=simx_opmode_oneshot; // We need to remove this command! (this is a special case, only for this command. See the doc!)
+    }
+    else
+        retCmd->setDataReply_nothing(false);
+}
 
-    	case simx_cmd_set_string_signal:
-        {
-            bool success=(simSetStringSignal(_cmdString.c_str(),_pureData,_pureDataSize)!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
-
-    	case simx_cmd_append_string_signal:
-        { // new since 31/1/2013
-            std::string theNewString;
-            int stringLength;
-            char* stringSignal=simGetStringSignal(_cmdString.c_str(),&stringLength);
-            if (stringSignal!=NULL)
-            {
-                theNewString=std::string(stringSignal,stringLength);
-                simReleaseBuffer(stringSignal);
-            }
-            theNewString+=std::string(_pureData,_pureDataSize);
-            bool success=(simSetStringSignal(_cmdString.c_str(),theNewString.c_str(),int(theNewString.length()))!=-1);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeReadStringStream(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int signalLength;
+    char* signalValue=simGetStringSignal(_cmdString.c_str(),&signalLength);
+    if (signalValue!=NULL)
+    {
+        retCmd->setDataReply_custom_copyBuffer(signalValue,signalLength,true);
+        simReleaseBuffer(signalValue);
+        simClearStringSignal(_cmdString.c_str());
+    }
+    else
+        retCmd->setDataReply_nothing(true);
+}
 
-    	case simx_cmd_get_object_float_parameter:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            float param;
-            bool success=(simGetObjectFloatParameter(handle,paramID,&param)>0);
-            retCmd->setDataReply_1float(param,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeSetFloatSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    float signalValue=littleEndianFloatConversion(((float*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simSetFloatSignal(_cmdString.c_str(),signalValue)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_object_int_parameter:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int param;
-            bool success=(simGetObjectIntParameter(handle,paramID,&param)>0);
-            retCmd->setDataReply_1int(param,success,otherSideIsBigEndian);
-        }
-    	break;
+void CSimxCmd::_executeSetIntegerSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int signalValue=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simSetIntegerSignal(_cmdString.c_str(),signalValue)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_object_float_parameter:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            float param=littleEndianFloatConversion(((float*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simSetObjectFloatParameter(handle,paramID,param)>0);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeSetStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    bool success=(simSetStringSignal(_cmdString.c_str(),_pureData,_pureDataSize)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_object_int_parameter:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
-            int param=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simSetObjectIntParameter(handle,paramID,param)>0);
-            retCmd->setDataReply_nothing(success);
-        }
-    	break;
+void CSimxCmd::_executeAppendStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{ // new since 31/1/2013
+    std::string theNewString;
+    int stringLength;
+    char* stringSignal=simGetStringSignal(_cmdString.c_str(),&stringLength);
+    if (stringSignal!=NULL)
+    {
+        theNewString=std::string(stringSignal,stringLength);
+        simReleaseBuffer(stringSignal);
+    }
+    theNewString+=std::string(_pureData,_pureDataSize);
+    bool success=(simSetStringSignal(_cmdString.c_str(),theNewString.c_str(),int(theNewString.length()))!=-1);
+    retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_get_model_property:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int prop=simGetModelProperty(handle);
-            retCmd->setDataReply_1int(prop,prop!=-1,otherSideIsBigEndian);
+void CSimxCmd::_executeGetObjectFloatParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    float param;
+    bool success=(simGetObjectFloatParameter(handle,paramID,&param)>0);
+    retCmd->setDataReply_1float(param,success,otherSideIsBigEndian);
+}
+
+void CSimxCmd::_executeGetObjectIntParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int param;
+    bool success=(simGetObjectIntParameter(handle,paramID,&param)>0);
+    retCmd->setDataReply_1int(param,success,otherSideIsBigEndian);
+}
+
+void CSimxCmd::_executeSetObjectFloatParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    float param=littleEndianFloatConversion(((float*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simSetObjectFloatParameter(handle,paramID,param)>0);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeSetObjectIntParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int paramID=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    int param=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simSetObjectIntParameter(handle,paramID,param)>0);
+    retCmd->setDataReply_nothing(success);
+}
+
+void CSimxCmd::_executeGetModelProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int prop=simGetModelProperty(handle);
+    retCmd->setDataReply_1int(prop,prop!=-1,otherSideIsBigEndian);
+}
+
+void CSimxCmd::_executeSetModelProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int prop=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
+    bool success=(simSetModelProperty(handle,prop)!=-1);
+    retCmd->setDataReply_nothing(success);
+}
+
+float* CSimxCmd::_prepareBatchReply(CSimxCmd* retCmd,int floatsPerHandle)
+{ // batched getters: one handle per int of pure data. The reply values are zeroed, the error flag is set if one handle fails
+    int handleCnt=_pureDataSize/4;
+    float* values=(float*)retCmd->_setPureDataSize(handleCnt*floatsPerHandle*4);
+    if (values!=NULL)
+        memset(values,0,handleCnt*floatsPerHandle*4);
+    retCmd->_status=0;
+    return(values);
+}
+
+void CSimxCmd::_executeGetJointPositions(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    float* values=_prepareBatchReply(retCmd,1);
+    for (int i=0;i<_pureDataSize/4;i++)
+    {
+        int handle=littleEndianIntConversion(((int*)_pureData)[i],otherSideIsBigEndian);
+        if (simGetJointPosition(handle,values+i)==-1)
+            retCmd->_status|=1;
+    }
+    // Endian conversion on the client side!
+}
+
+void CSimxCmd::_executeGetJointForces(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    float* values=_prepareBatchReply(retCmd,1);
+    for (int i=0;i<_pureDataSize/4;i++)
+    {
+        int handle=littleEndianIntConversion(((int*)_pureData)[i],otherSideIsBigEndian);
+        if (simJointGetForce(handle,values+i)==-1)
+            retCmd->_status|=1;
+    }
+    // Endian conversion on the client side!
+}
+
+void CSimxCmd::_executeGetObjectVelocities(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    float* values=_prepareBatchReply(retCmd,6);
+    for (int i=0;i<_pureDataSize/4;i++)
+    {
+        int handle=littleEndianIntConversion(((int*)_pureData)[i],otherSideIsBigEndian);
+        if (simGetObjectVelocity(handle,values+6*i,values+6*i+3)==-1)
+            retCmd->_status|=1;
+    }
+    // Endian conversion on the client side!
+}
+
+void CSimxCmd::_executeGetObjectPoses(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int relativeToObject=littleEndianIntConversion(((int*)(_cmdData+0))[1],otherSideIsBigEndian);
+    float* values=_prepareBatchReply(retCmd,7);
+    for (int i=0;i<_pureDataSize/4;i++)
+    {
+        int handle=littleEndianIntConversion(((int*)_pureData)[i],otherSideIsBigEndian);
+        if (simGetObjectPosition(handle,relativeToObject,values+7*i)==-1)
+            retCmd->_status|=1;
+        if (simGetObjectQuaternion(handle,relativeToObject,values+7*i+3)==-1)
+            retCmd->_status|=1;
+    }
+    // Endian conversion on the client side!
+}
+
+bool CSimxCmd::_getVisionSensorRegion(int handle,int res[2],int roi[5],bool otherSideIsBigEndian)
+{ // region of interest reads: roi is x, y, width, height and the downsampling factor. False if the region is not inside the image
+    if ((_pureDataSize<5*4)||(simGetVisionSensorResolution(handle,res)==-1))
+        return(false);
+    for (int i=0;i<5;i++)
+        roi[i]=littleEndianIntConversion(((int*)_pureData)[i],otherSideIsBigEndian);
+    if ((roi[4]<1)||(roi[4]>SIMX_ROI_MAX_FACTOR)||(roi[0]<0)||(roi[1]<0))
+        return(false);
+    return((roi[2]>=roi[4])&&(roi[3]>=roi[4])&&(roi[2]<=res[0]-roi[0])&&(roi[3]<=res[1]-roi[1]));
+}
+
+void CSimxCmd::_executeGetVisionSensorImageRegion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res[2];
+    int roi[5];
+    bool success=false;
+    if (_getVisionSensorRegion(handle,res,roi,otherSideIsBigEndian))
+    {
+        bool gray=(_rawCmdID==simx_cmd_get_vision_sensor_image_bw_roi);
+        int outRes[2]={roi[2]/roi[4],roi[3]/roi[4]};
+        unsigned char* img=simGetVisionSensorCharImage(handle,NULL,NULL);
+        if (img!=NULL)
+        {
+            success=true;
+            char* dat=retCmd->_setPureDataSize(4+4+outRes[0]*outRes[1]*(gray?1:3));
+            ((int*)(dat+0))[0]=littleEndianIntConversion(outRes[0],otherSideIsBigEndian);
+            ((int*)(dat+0))[1]=littleEndianIntConversion(outRes[1],otherSideIsBigEndian);
+            extractImageRegion(img,res[0],roi[0],roi[1],roi[2],roi[3],roi[4],gray,(BYTE*)dat+8);
+            simReleaseBuffer((simChar*)img);
+            retCmd->_status=0;
         }
-    	break;
+    }
+    if (!success)
+        retCmd->setDataReply_nothing(success);
+}
 
-    	case simx_cmd_set_model_property:
-        {
-            int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
-            int prop=littleEndianIntConversion(((int*)(_pureData+0))[0],otherSideIsBigEndian);
-            bool success=(simSetModelProperty(handle,prop)!=-1);
-            retCmd->setDataReply_nothing(success);
+void CSimxCmd::_executeGetVisionSensorDepthBufferRegion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res[2];
+    int roi[5];
+    bool success=false;
+    if (_getVisionSensorRegion(handle,res,roi,otherSideIsBigEndian))
+    {
+        int outRes[2]={roi[2]/roi[4],roi[3]/roi[4]};
+        float* img=simGetVisionSensorDepthBuffer(handle);
+        if (img!=NULL)
+        {
+            success=true;
+            char* dat=retCmd->_setPureDataSize(4+4+outRes[0]*outRes[1]*4);
+            ((int*)(dat+0))[0]=littleEndianIntConversion(outRes[0],otherSideIsBigEndian);
+            ((int*)(dat+0))[1]=littleEndianIntConversion(outRes[1],otherSideIsBigEndian);
+            float* values=((float*)dat)+2;
+            extractDepthRegion(img,res[0],roi[0],roi[1],roi[2],roi[3],roi[4],values);
+            for (int i=0;i<outRes[0]*outRes[1];i++)
+                values[i]=littleEndianFloatConversion(values[i],otherSideIsBigEndian);
+            simReleaseBuffer((simChar*)img);
+            retCmd->_status=0;
         }
     }
+    if (!success)
+        retCmd->setDataReply_nothing(success);
+}
 
-    // ******************************* error reporting **********************************
-    char* err=simGetLastError(); // this also clears the last error
-    if (err!=NULL)
+void CSimxCmd::_executeGetVisionSensorDepthBufferU16(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian)
+{
+    int handle=littleEndianIntConversion(((int*)(_cmdData+0))[0],otherSideIsBigEndian);
+    int res[2];
+    float clippingPlanes[2];
+    bool success=false;
+    if ( (simGetVisionSensorResolution(handle,res)!=-1)&&(simGetObjectFloatParameter(handle,sim_visionfloatparam_near_clipping,clippingPlanes+0)>0)&&(simGetObjectFloatParameter(handle,sim_visionfloatparam_far_clipping,clippingPlanes+1)>0) )
     {
-        sock->addErrorString(err);
-        simReleaseBuffer(err);
+        float* img=simGetVisionSensorDepthBuffer(handle);
+        if (img!=NULL)
+        {
+            success=true;
+            char* dat=retCmd->_setPureDataSize(4+4+4+4+res[0]*res[1]*2);
+            ((int*)(dat+0))[0]=littleEndianIntConversion(res[0],otherSideIsBigEndian);
+            ((int*)(dat+0))[1]=littleEndianIntConversion(res[1],otherSideIsBigEndian);
+            ((float*)(dat+0))[2]=littleEndianFloatConversion(clippingPlanes[0],otherSideIsBigEndian);
+            ((float*)(dat+0))[3]=littleEndianFloatConversion(clippingPlanes[1],otherSideIsBigEndian);
+            WORD* values=(WORD*)(dat+16);
+            quantizeDepthToWord(img,values,res[0]*res[1]);
+            if (otherSideIsBigEndian)
+            {
+                for (int i=0;i<res[0]*res[1];i++)
+                    values[i]=littleEndianWordConversion(values[i],otherSideIsBigEndian);
+            }
+            simReleaseBuffer((simChar*)img);
+            retCmd->_status=0;
+        }
     }
-    return(retCmd);
+    if (!success)
+        retCmd->setDataReply_nothing(success);
 }
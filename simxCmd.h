@@ -4,7 +4,64 @@
 #include <vector>
 #include "porting.h"
 
+#define SIMX_CMD_SMALL_PURE_DATA_SIZE 16 // pure data up to that size is stored inside the command (most replies)
+#define SIMX_CMD_POOL_MAX_FREE 4096 // max. number of released commands kept for reuse
+#define SIMX_CMD_POOL_CLASS_CNT 24 // larger pure data is recycled in power of 2 size classes, from 32 bytes to 256 MB
+#define SIMX_CMD_POOL_MAX_FREE_BYTES 67108864 // max. total size of released pure data buffers kept for reuse
+
+#define SIMX_CMDDATA_NONE               0 // command data layouts
+#define SIMX_CMDDATA_4BYTES             1
+#define SIMX_CMDDATA_8BYTES             2
+#define SIMX_CMDDATA_1STRING            3
+#define SIMX_CMDDATA_4BYTES2STRINGS     4
+
+#define SIMX_CMDFLAG_IMAGEREPLY         1 // the reply starts with an 8-byte resolution header (2 ints). Everything after it (the pixels, but also further header fields, e.g. the u16 depth buffer's clipping planes) is compared as tiles
+
+#define SIMX_CMDOPTION_SENDONLYONCHANGE 2 // request sub-header status byte (bit0: do not overwrite). Streaming replies are only sent when they change
+#define SIMX_CMDSTATUS_UNCHANGED        2 // reply sub-header status byte (bit0: error). Keep-alive marker: the reply data didn't change and is omitted
+#define SIMX_SENDONLYONCHANGE_KEEPALIVE 1000 // in ms. Max. time without any reply for a send-only-on-change streaming command
+
+// Delta encoding of streamed images (SIMX_CMDFLAG_IMAGEREPLY commands). A keyframe is a normal reply. A delta reply is
+// flagged SIMX_CMDSTATUS_DELTA and contains: the resolution (2 ints), the tile size (int), the number of changed tiles (int),
+// then for each changed tile its index (int) followed by its bytes (the last tile may be shorter). Tiles cover all the reply
+// data after the resolution, so a changed clipping plane of the u16 depth buffer simply changes tile 0.
+// The client applies the changed tiles to the last frame it received for that command
+#define SIMX_CMDOPTION_DELTAENCODING    4 // request sub-header status byte. Streamed image replies are delta encoded
+#define SIMX_CMDSTATUS_DELTA            4 // reply sub-header status byte. The reply is a delta to the previous frame
+#define SIMX_DELTA_TILE_SIZE            1024 // in bytes of reply data after the resolution
+#define SIMX_DELTA_KEYFRAME_INTERVAL    2000 // in ms. Max. time between two keyframes
+
+// Compression of large replies. A compressed reply is flagged SIMX_CMDSTATUS_COMPRESSED and its pure data is the
+// uncompressed size (int), followed by the LZ4 block (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+#define SIMX_CMDOPTION_COMPRESSION      8 // request sub-header status byte. The client accepts compressed replies for that command
+#define SIMX_CMDSTATUS_COMPRESSED       8 // reply sub-header status byte
+#define SIMX_COMPRESSION_MIN_SIZE       1024 // in bytes. Smaller replies are never compressed
+
+#define SIMX_CMD_DESCRIPTOR_INDEX_SIZE simx_cmd4bytes2strings_end // all command IDs are below this
+
+// Batched getters, specific to this plugin (clients must use the same IDs). The command data starts with a batch ID
+// chosen by the client, so that several batches can be streamed at the same time. The pure data is the array of handles,
+// the reply a packed float array (endian conversion on the client side). If any handle fails, the reply is flagged as error
+#define simx_cmd_get_joint_positions    (simx_cmd4bytes_start+0xf00) // 1 float per handle
+#define simx_cmd_get_joint_forces       (simx_cmd4bytes_start+0xf01) // 1 float per handle
+#define simx_cmd_get_object_velocities  (simx_cmd4bytes_start+0xf02) // 6 floats per handle: linear, then angular velocity
+#define simx_cmd_get_object_poses       (simx_cmd8bytes_start+0xf00) // 2nd int of command data: relative-to handle. 7 floats per handle: position, then quaternion
+
+// Quantized depth buffer, specific to this plugin. The command data is the vision sensor handle. The reply is the resolution
+// (2 ints), the near and far clipping planes (2 floats), then one WORD per pixel: depth=near+value/65535*(far-near)
+#define simx_cmd_get_vision_sensor_depth_buffer_u16 (simx_cmd4bytes_start+0xf03)
+
+// Region of interest reads, specific to this plugin. The command data is the vision sensor handle, then a region ID chosen
+// by the client (several regions of the same sensor can be streamed at the same time). The pure data is x, y, width, height
+// (in sensor pixels, the region must be inside the image) and an integer downsampling factor (1-SIMX_ROI_MAX_FACTOR).
+// The reply has the layout of the full image reply, with a resolution of (width/factor)x(height/factor)
+#define simx_cmd_get_vision_sensor_image_rgb_roi    (simx_cmd8bytes_start+0xf01) // blocks of factor*factor pixels are averaged
+#define simx_cmd_get_vision_sensor_image_bw_roi     (simx_cmd8bytes_start+0xf02)
+#define simx_cmd_get_vision_sensor_depth_buffer_roi (simx_cmd8bytes_start+0xf03) // subsampled: the first value of each block
+#define SIMX_ROI_MAX_FACTOR                         256
+
 class CSimxSocket; // forward declaration
+struct SSimxCmdDescriptor;
 
 class CSimxCmd
 {
@@ -13,15 +70,31 @@ public:
     CSimxCmd();
     virtual ~CSimxCmd();
 
+    // Commands are created and destroyed for every message and every stream on every simulation pass: we recycle them
+    static void* operator new(size_t size);
+    static void operator delete(void* p,size_t size);
+
+    static int getCommandDataLayout(int rawCmdID);
+    static const SSimxCmdDescriptor* getCommandDescriptor(int rawCmdID);
+
     int getRawCommand();
+    void setSendOnlyOnChange(bool s);
+    void setDeltaEncoding(bool d);
+    void setCompression(bool c);
     int getOperationMode();
     void setLastTimeProcessed(DWORD t);
     DWORD getLastTimeProcessed();
 
     bool areCommandAndCommandDataSame(const CSimxCmd* otherCmd);
+    unsigned int getCommandAndCommandDataHash() const;
+    int getYourDataSize();
+    char* writeYourData(char* dest,bool otherSideIsBigEndian);
     void appendYourData(std::vector<char>& dataString,bool otherSideIsBigEndian);
+    int getYourMemorizedSplitDataSize(bool calledFromContainer);
+    bool writeYourMemorizedSplitData(bool calledFromContainer,char*& dest,bool& removeCommand,bool otherSideIsBigEndian);
     bool appendYourMemorizedSplitData(bool calledFromContainer,std::vector<char>& dataString,bool& removeCommand,bool otherSideIsBigEndian);
     CSimxCmd* copyYourself();
+    CSimxCmd* copyYourIdentity();
     void setDataReply_nothing(bool success);
     void setDataReply_custom_transferBuffer(char* customData,int customDataSize,bool success);
     void setDataReply_custom_copyBuffer(char* customData,int customDataSize,bool success);
@@ -38,6 +111,125 @@ public:
 protected:
     CSimxCmd* _executeCommand(CSimxSocket* sock,bool otherSideIsBigEndian);
 
+    // Command handlers, dispatched through _descriptors:
+    void _executeGetJointPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetJointMatrix(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeReadProximitySensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetUiHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeLoadModel(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeLoadScene(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetJointPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetSphericalJointMatrix(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetJointTargetVelocity(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetJointTargetPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeStartPauseStopSimulation(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSynchronousNext(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSynchronousEnable(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSynchronousDisable(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetVisionSensorImage(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetVisionSensorImage(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetJointForce(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetJointForce(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeReadForceSensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeBreakForceSensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeReadVisionSensor(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectParent(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectChild(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeTransferFile(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeEraseFile(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeLoadUi(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetUiSlider(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetUiSlider(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetUiEventButton(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetUiButtonProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetUiButtonProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeAddStatusbarMessage(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeAuxConsoleOpen(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeCreateDummy(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeAuxConsoleClose(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeAuxConsolePrint(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeAuxConsoleShow(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetVisionSensorDepthBuffer(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectOrientation(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectOrientation2(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectQuaternion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectPosition2(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectVelocity(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectOrientation(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectPosition(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectQuaternion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectParent(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetUiButtonLabel(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetLastErrors(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectGroupData(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeCallScriptFunction(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetArrayParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetArrayParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetBooleanParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetBooleanParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetIntegerParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetIntegerParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetFloatingParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetFloatingParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetStringParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetCollisionHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetDistanceHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetCollectionHandle(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeReadCollision(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeReadDistance(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeRemoveObject(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeRemoveModel(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeRemoveUi(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeCloseScene(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjects(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeDisplayDialog(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeEndDialog(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetDialogResult(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetDialogInput(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeCopyPasteObjects(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectSelection(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectSelection(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeClearFloatSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeClearIntegerSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeClearStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetFloatSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetIntegerSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetAndClearStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeReadStringStream(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetFloatSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetIntegerSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeAppendStringSignal(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectFloatParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectIntParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectFloatParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetObjectIntParameter(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetModelProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeSetModelProperty(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetJointPositions(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetJointForces(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectVelocities(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetObjectPoses(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    float* _prepareBatchReply(CSimxCmd* retCmd,int floatsPerHandle);
+    void _executeGetVisionSensorImageRegion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetVisionSensorDepthBufferRegion(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    void _executeGetVisionSensorDepthBufferU16(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    bool _getVisionSensorRegion(int handle,int res[2],int roi[5],bool otherSideIsBigEndian);
+
+    static const SSimxCmdDescriptor _descriptors[];
+    void _getCommandDataSizes(int& commandByteDataSize,int& commandStringDataSize);
+    char* _writeCommandData(char* dest,int commandByteDataSize,int commandStringDataSize);
+    int _getSplitDataPart(int& pureDataOffset);
+    CSimxCmd* _encodeReply(CSimxCmd* retCmd,int currentTime,bool otherSideIsBigEndian);
+    CSimxCmd* _suppressUnchangedReply(CSimxCmd* retCmd,int currentTime);
+    void _deltaEncodeReply(CSimxCmd* retCmd,int currentTime,bool otherSideIsBigEndian);
+    void _compressReply(CSimxCmd* retCmd,bool otherSideIsBigEndian);
+    char* _setPureDataSize(int size);
+    void _releasePureData();
+
     int _opMode;
 
     int _rawCmdID;
@@ -48,8 +240,10 @@ protected:
     std::string _cmdString2;
 
     // Following is pure data:
-    char* _pureData;
+    char* _pureData; // points to _smallPureData, to a pooled buffer, or to a heap buffer
     int _pureDataSize;
+    int _pureDataCapacity; // size class of a pooled buffer, 0 otherwise
+    char _smallPureData[SIMX_CMD_SMALL_PURE_DATA_SIZE];
 
     BYTE _status;
     WORD _processingDelayOrMaxDataSize;
@@ -57,4 +251,28 @@ protected:
     int _dataSizeLeftToBeSent; // for simx_opmode_continuous_split
     int _executionTime; // in simulation time (in ms), or 0 if simulation is not running
     CSimxCmd* _memorizedSplitCmd;
+
+    // Send-only-on-change streaming:
+    bool _sendOnlyOnChange;
+    bool _hasLastSentReply;
+    BYTE _lastSentReplyStatus;
+    int _lastSentReplyTime;
+    std::vector<char> _lastSentReply;
+
+    // Delta encoding of streamed images:
+    bool _deltaEncoding;
+    int _lastKeyframeTime;
+    std::vector<char> _lastSentFrame; // the frame the client has, once it applied all replies sent so far
+    std::vector<int> _changedTiles;
+
+    // Compression of large replies:
+    bool _compression;
+    std::vector<char> _compressionBuffer;
+};
+
+struct SSimxCmdDescriptor
+{
+    int rawCmdID;
+    void (CSimxCmd::*handler)(CSimxCmd* retCmd,CSimxSocket* sock,bool otherSideIsBigEndian);
+    int flags; // SIMX_CMDFLAG_*
 };
@@ -12,6 +12,9 @@ CSimxConnections::~CSimxConnections()
 
 void CSimxConnections::removeAllConnections()
 {
+#if defined (__linux)
+    _reactor.stop(); // all sockets are released from the reactor thread
+#endif /* __linux */
     for (unsigned int i=0;i<_allSocketConnections.size();i++)
         delete _allSocketConnections[i];
     _allSocketConnections.clear();
@@ -19,6 +22,10 @@ void CSimxConnections::removeAllConnections()
 
 void CSimxConnections::addSocketConnection(CSimxSocket* conn)
 {
+#if defined (__linux)
+    if ( conn->getUsesEventLoop()&&(conn->getListeningSocket()!=INVALID_SOCKET) )
+        _reactor.addSocket(conn); // otherwise, instancePass adds it once it could start listening
+#endif /* __linux */
     _allSocketConnections.push_back(conn);
 }
 
@@ -41,6 +48,10 @@ void CSimxConnections::removeSocketConnection(CSimxSocket* conn)
     {
         if (_allSocketConnections[i]==conn)
         {
+#if defined (__linux)
+            if (conn->getUsesEventLoop())
+                _reactor.removeSocket(conn);
+#endif /* __linux */
             delete conn;
             _allSocketConnections.erase(_allSocketConnections.begin()+i);
             break;
@@ -117,5 +128,11 @@ void CSimxConnections::simulationEnded()
 void CSimxConnections::instancePass()
 {
     for (unsigned int i=0;i<_allSocketConnections.size();i++)
+    {
+#if defined (__linux)
+        if (_allSocketConnections[i]->retryListening())
+            _reactor.addSocket(_allSocketConnections[i]);
+#endif /* __linux */
         _allSocketConnections[i]->instancePass();
+    }
 }
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "simxSocket.h"
+#include "simxReactor.h"
 
 class CSimxConnections
 {
@@ -27,5 +28,8 @@ public:
 
 protected:
     std::vector<CSimxSocket*> _allSocketConnections;
+#if defined (__linux)
+    CSimxReactor _reactor; // serves all sockets in event loop mode
+#endif /* __linux */
 // 3/3/2014 CSimxSocket* _synchronousSimulationTriggerConnection;
 };
@@ -51,8 +51,9 @@ void CSimxContainer::clearAll()
     for (unsigned int i=0;i<_allCommands.size();i++)
         delete _allCommands[i];
     _allCommands.clear();
-    for (unsigned int i=0;i<_partialCommands.size();i++)
-        delete[] _partialCommands[i];
+    _commandIndex.clear();
+    for (std::unordered_multimap<unsigned int,SSimxPartialCmd>::iterator it=_partialCommands.begin();it!=_partialCommands.end();it++)
+        delete[] it->second.data;
     _partialCommands.clear();
 
     _messageID=-1;
@@ -64,32 +65,33 @@ int CSimxContainer::_arePartialCommandsSame(const char* buff1,const char* buff2,
     int cmd2=littleEndianIntConversion(((int*)(buff2+simx_cmdheaderoffset_cmd))[0],otherSideIsBigEndian)&simx_cmdmask;
     if (cmd1==cmd2)
     { // commands are same. Check the command data now:
-        if ((cmd1>simx_cmd4bytes_start)&&(cmd1<simx_cmd8bytes_start))
+        switch (CSimxCmd::getCommandDataLayout(cmd1))
         {
-            if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE))[0] )
-                return(0);
-        }
-        if ((cmd1>simx_cmd8bytes_start)&&(cmd1<simx_cmd1string_start))
-        {
-            if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE))[0] )
-                return(0);
-            if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE+4))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE+4))[0] )
-                return(0);
-        }
-        if ((cmd1>simx_cmd1string_start)&&(cmd1<simx_cmd4bytes2strings_start))
-        {
-            if (strcmp(buff1+SIMX_SUBHEADER_SIZE,buff2+SIMX_SUBHEADER_SIZE)!=0)
-                return(0);
-        }
-        if ((cmd1>simx_cmd4bytes2strings_start)&&(cmd1<simx_cmd4bytes2strings_end))
-        {
-            if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE))[0] )
-                return(0);
-            if (strcmp(buff1+SIMX_SUBHEADER_SIZE+4,buff2+SIMX_SUBHEADER_SIZE+4)!=0)
-                return(0);
-            int l=int(strlen(buff1+SIMX_SUBHEADER_SIZE+4));
-            if (strcmp(buff1+SIMX_SUBHEADER_SIZE+4+l+1,buff2+SIMX_SUBHEADER_SIZE+4+l+1)!=0)
-                return(0);
+            case SIMX_CMDDATA_4BYTES:
+                if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE))[0] )
+                    return(0);
+                break;
+            case SIMX_CMDDATA_8BYTES:
+                if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE))[0] )
+                    return(0);
+                if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE+4))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE+4))[0] )
+                    return(0);
+                break;
+            case SIMX_CMDDATA_1STRING:
+                if (strcmp(buff1+SIMX_SUBHEADER_SIZE,buff2+SIMX_SUBHEADER_SIZE)!=0)
+                    return(0);
+                break;
+            case SIMX_CMDDATA_4BYTES2STRINGS:
+            {
+                if ( ((int*)(buff1+SIMX_SUBHEADER_SIZE))[0]!=((int*)(buff2+SIMX_SUBHEADER_SIZE))[0] )
+                    return(0);
+                if (strcmp(buff1+SIMX_SUBHEADER_SIZE+4,buff2+SIMX_SUBHEADER_SIZE+4)!=0)
+                    return(0);
+                int l=int(strlen(buff1+SIMX_SUBHEADER_SIZE+4));
+                if (strcmp(buff1+SIMX_SUBHEADER_SIZE+4+l+1,buff2+SIMX_SUBHEADER_SIZE+4+l+1)!=0)
+                    return(0);
+                break;
+            }
         }
         int size1=littleEndianIntConversion(((int*)(buff1+simx_cmdheaderoffset_full_mem_size))[0],otherSideIsBigEndian);
         int size2=littleEndianIntConversion(((int*)(buff2+simx_cmdheaderoffset_full_mem_size))[0],otherSideIsBigEndian);
@@ -100,54 +102,89 @@ int CSimxContainer::_arePartialCommandsSame(const char* buff1,const char* buff2,
     return(0);
 }
 
-char* CSimxContainer::addPartialCommand(const char* buffer,bool otherSideIsBigEndian)
-{
-    for (unsigned int i=0;i<_partialCommands.size();i++)
+unsigned int CSimxContainer::_getPartialCommandHash(const char* buffer,bool otherSideIsBigEndian)
+{ // partial commands that _arePartialCommandsSame doesn't consider different (ret. value 0) have the same hash
+    int cmd=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_cmd))[0],otherSideIsBigEndian)&simx_cmdmask;
+    unsigned int hash=getHash((const char*)&cmd,sizeof(cmd));
+    WORD pdataOffset0=littleEndianWordConversion(((WORD*)(buffer+simx_cmdheaderoffset_pdata_offset0))[0],otherSideIsBigEndian);
+    return(getHash(buffer+SIMX_SUBHEADER_SIZE,pdataOffset0,hash));
+}
+
+bool CSimxContainer::_addReceivedRange(SSimxPartialCmd& partialCmd,int start,int end,int pureDataSize)
+{ // returns true once the whole pure data was received
+    std::map<int,int>::iterator it=partialCmd.receivedRanges.upper_bound(start);
+    if (it!=partialCmd.receivedRanges.begin())
     {
-        int res=_arePartialCommandsSame(buffer,_partialCommands[i],otherSideIsBigEndian);
-        if (res==2)
-        { // same commands, but somehow different memory footprints. Erase the one we have stored here and break from the loop
-            delete[] _partialCommands[i];
-            _partialCommands.erase(_partialCommands.begin()+i);
-            break;
-        }
-        else
-        {
-            if (res==1)
-            { // same commands and same footprints. Merge the new command with the old:
-                int fullSize=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_full_mem_size))[0],otherSideIsBigEndian);
-                int memSize=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_mem_size))[0],otherSideIsBigEndian);
-                WORD pdataOffset0=littleEndianWordConversion(((WORD*)(buffer+simx_cmdheaderoffset_pdata_offset0))[0],otherSideIsBigEndian);
-                int pdataOffset1=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_pdata_offset1))[0],otherSideIsBigEndian);
-                int pdataSize=memSize-SIMX_SUBHEADER_SIZE-pdataOffset0;
-                for (int cnt=0;cnt<pdataSize;cnt++)
-                    _partialCommands[i][SIMX_SUBHEADER_SIZE+pdataOffset0+pdataOffset1+cnt]=buffer[SIMX_SUBHEADER_SIZE+pdataOffset0+cnt];
-                // Is that merged command complete yet?
-                if (SIMX_SUBHEADER_SIZE+pdataOffset0+pdataOffset1+pdataSize>=fullSize)
-                { // yes!
-                    char* retVal=_partialCommands[i];
-                    _partialCommands.erase(_partialCommands.begin()+i);
-                    return(retVal);
-                }
-                else
-                    return(NULL);
-            }
+        std::map<int,int>::iterator prev=it;
+        prev--;
+        if (prev->second>=start)
+        { // overlaps or touches the previous range
+            start=prev->first;
+            if (prev->second>end)
+                end=prev->second;
+            partialCmd.receivedRanges.erase(prev);
         }
     }
-    // the partial command is not yet present! We simply add it:
+    while ((it!=partialCmd.receivedRanges.end())&&(it->first<=end))
+    { // overlaps or touches following ranges
+        if (it->second>end)
+            end=it->second;
+        it=partialCmd.receivedRanges.erase(it);
+    }
+    partialCmd.receivedRanges[start]=end;
+    return((partialCmd.receivedRanges.size()==1)&&(start==0)&&(end>=pureDataSize));
+}
+
+char* CSimxContainer::addPartialCommand(const char* buffer,bool otherSideIsBigEndian)
+{ // returns the complete command once all its parts were received (the caller then owns it), otherwise NULL
     int memSize=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_mem_size))[0],otherSideIsBigEndian);
     int fullSize=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_full_mem_size))[0],otherSideIsBigEndian);
-    char* dat=new char[fullSize];
     WORD pdataOffset0=littleEndianWordConversion(((WORD*)(buffer+simx_cmdheaderoffset_pdata_offset0))[0],otherSideIsBigEndian);
     int pdataOffset1=littleEndianIntConversion(((int*)(buffer+simx_cmdheaderoffset_pdata_offset1))[0],otherSideIsBigEndian);
-    int pdataSize=memSize-SIMX_SUBHEADER_SIZE-pdataOffset0;
-    for (int cnt=0;cnt<SIMX_SUBHEADER_SIZE+pdataOffset0;cnt++)
-        dat[cnt]=buffer[cnt];
-    // We need to correct for the correct memory footprint here:
-    ((int*)(dat+simx_cmdheaderoffset_mem_size))[0]=littleEndianIntConversion(fullSize,otherSideIsBigEndian);
-    for (int cnt=0;cnt<pdataSize;cnt++)
-        dat[SIMX_SUBHEADER_SIZE+pdataOffset0+pdataOffset1+cnt]=buffer[SIMX_SUBHEADER_SIZE+pdataOffset0+cnt];
-    _partialCommands.push_back(dat);
+    int pureDataStart=SIMX_SUBHEADER_SIZE+pdataOffset0;
+    int pdataSize=memSize-pureDataStart;
+    if ((fullSize<pureDataStart)||(fullSize<memSize))
+        return(NULL); // the full command can't hold the sub-header and command data we copy, or this part. Ignore it
+    if ((pdataSize<0)||(pdataOffset1<0)||(pdataOffset1>fullSize-pureDataStart-pdataSize))
+        return(NULL); // corrupt part, ignore it
+
+    unsigned int hash=_getPartialCommandHash(buffer,otherSideIsBigEndian);
+    std::pair<std::unordered_multimap<unsigned int,SSimxPartialCmd>::iterator,std::unordered_multimap<unsigned int,SSimxPartialCmd>::iterator> range=_partialCommands.equal_range(hash);
+    std::unordered_multimap<unsigned int,SSimxPartialCmd>::iterator entry=_partialCommands.end();
+    for (std::unordered_multimap<unsigned int,SSimxPartialCmd>::iterator it=range.first;it!=range.second;it++)
+    {
+        int res=_arePartialCommandsSame(buffer,it->second.data,otherSideIsBigEndian);
+        if (res==2)
+        { // same commands, but somehow different memory footprints. Erase the one we have stored here
+            delete[] it->second.data;
+            _partialCommands.erase(it);
+            break;
+        }
+        if (res==1)
+        { // same commands and same footprints. We merge the new part with the old
+            entry=it;
+            break;
+        }
+    }
+    if (entry==_partialCommands.end())
+    { // the partial command is not yet present! We add it:
+        SSimxPartialCmd partialCmd;
+        partialCmd.data=new char[fullSize];
+        partialCmd.pureDataStart=pureDataStart;
+        memcpy(partialCmd.data,buffer,pureDataStart);
+        // We need to correct for the correct memory footprint here:
+        ((int*)(partialCmd.data+simx_cmdheaderoffset_mem_size))[0]=littleEndianIntConversion(fullSize,otherSideIsBigEndian);
+        entry=_partialCommands.insert(std::make_pair(hash,partialCmd));
+    }
+    SSimxPartialCmd& partialCmd=entry->second;
+    memcpy(partialCmd.data+partialCmd.pureDataStart+pdataOffset1,buffer+pureDataStart,pdataSize);
+    // Duplicated or out-of-order parts are fine: the command is complete once its whole pure data was received
+    if (_addReceivedRange(partialCmd,pdataOffset1,pdataOffset1+pdataSize,fullSize-partialCmd.pureDataStart))
+    {
+        char* retVal=partialCmd.data;
+        _partialCommands.erase(entry);
+        return(retVal);
+    }
     return(NULL);
 }
 
@@ -157,9 +194,12 @@ void CSimxContainer::addCommand(CSimxCmd* cmd,bool doNotOverwriteSameCommand)
     {
         int sci=_getIndexOfSimilarCommand(cmd);
         if ((sci==-1)||doNotOverwriteSameCommand)
-            _allCommands.push_back(cmd); // command not yet there. just append it
+        { // command not yet there. just append it
+            _commandIndex.insert(std::make_pair(cmd->getCommandAndCommandDataHash(),int(_allCommands.size())));
+            _allCommands.push_back(cmd);
+        }
         else
-        { // Command already there
+        { // Command already there (the replacing command has the same hash, the index stays valid)
             if ((cmd->getOperationMode()==simx_opmode_oneshot_split)&&(_allCommands[sci]->getOperationMode()==simx_opmode_oneshot_split))
             { // let the command finish, and only in above case (don't do this with continuous commands!!). Special case!
                 delete cmd;
@@ -176,13 +216,24 @@ void CSimxContainer::addCommand(CSimxCmd* cmd,bool doNotOverwriteSameCommand)
 }
 
 int CSimxContainer::_getIndexOfSimilarCommand(CSimxCmd* cmd)
-{
-    for (unsigned int i=0;i<_allCommands.size();i++)
+{ // returns the first similar command in _allCommands, or -1
+    int retVal=-1;
+    std::pair<std::unordered_multimap<unsigned int,int>::iterator,std::unordered_multimap<unsigned int,int>::iterator> range=_commandIndex.equal_range(cmd->getCommandAndCommandDataHash());
+    for (std::unordered_multimap<unsigned int,int>::iterator it=range.first;it!=range.second;it++)
     {
-        if (_allCommands[i]->areCommandAndCommandDataSame(cmd))
-            return((int)i);
+        if (((retVal==-1)||(it->second<retVal))&&_allCommands[it->second]->areCommandAndCommandDataSame(cmd))
+            retVal=it->second;
     }
-    return(-1);
+    return(retVal);
+}
+
+void CSimxContainer::_rebuildCommandIndex()
+{ // call after commands were removed from _allCommands (indices have shifted)
+    _commandIndex.clear();
+    if (!_isInputContainer)
+        return;
+    for (unsigned int i=0;i<_allCommands.size();i++)
+        _commandIndex.insert(std::make_pair(_allCommands[i]->getCommandAndCommandDataHash(),int(i)));
 }
 
 void CSimxContainer::executeCommands(CSimxContainer* outputContainer,CSimxSocket* sock)
@@ -235,14 +286,19 @@ void CSimxContainer::executeCommands(CSimxContainer* outputContainer,CSimxSocket
 
 void CSimxContainer::_removeNonContinuousCommands()
 { // this also keeps simx_opmode_oneshot_split commands!!!
+    // Single compacting pass: kept commands are moved down, in order
+    unsigned int keptCnt=0;
     for (unsigned int i=0;i<_allCommands.size();i++)
     {
         if ( (_allCommands[i]->getOperationMode()!=simx_opmode_continuous)&&(_allCommands[i]->getOperationMode()!=simx_opmode_continuous_split)&&(_allCommands[i]->getOperationMode()!=simx_opmode_oneshot_split) )
-        {
             delete _allCommands[i];
-            _allCommands.erase(_allCommands.begin()+i);
-            i--; // reprocess this position
-        }
+        else
+            _allCommands[keptCnt++]=_allCommands[i];
+    }
+    if (keptCnt!=_allCommands.size())
+    {
+        _allCommands.resize(keptCnt);
+        _rebuildCommandIndex();
     }
 }
 
@@ -260,11 +316,20 @@ int CSimxContainer::getStreamCommandCount()
 }
 
 
-int CSimxContainer::getDataString(std::vector<char>& dataString,bool otherSideIsBigEndian)
-{ // returns the number of commands fetched
+int CSimxContainer::getDataStringSize()
+{ // the size getDataString/writeDataString will produce
+    if (_isInputContainer)
+        return(0); // apply only on output containers
+    int retVal=SIMX_HEADER_SIZE;
+    for (unsigned int i=0;i<_allCommands.size();i++)
+        retVal+=_allCommands[i]->getYourDataSize();
+    return(retVal);
+}
+
+int CSimxContainer::writeDataString(char* dest,bool otherSideIsBigEndian)
+{ // dest must have room for getDataStringSize() bytes. Returns the number of commands written
     if (_isInputContainer)
         return(0); // apply only on output containers
-    dataString.clear();
     // 1. Prepare the header:
     char header[SIMX_HEADER_SIZE];
     // The CRC is added later
@@ -275,36 +340,71 @@ int CSimxContainer::getDataString(std::vector<char>& dataString,bool otherSideIs
     ((WORD*)(header+simx_headeroffset_scene_id))[0]=littleEndianWordConversion(_sceneID,otherSideIsBigEndian);
     header[simx_headeroffset_server_state]=_serverState;
 
-    for (int i=0;i<SIMX_HEADER_SIZE;i++)
-        dataString.push_back(header[i]);
+    memcpy(dest,header,SIMX_HEADER_SIZE);
+    dest+=SIMX_HEADER_SIZE;
     // 2. Prepare the individual commands (or command replies). Only non-split and non-gradual commands are taken here:
     for (unsigned int i=0;i<_allCommands.size();i++)
-        _allCommands[i]->appendYourData(dataString,_otherSideIsBigEndian);
+        dest=_allCommands[i]->writeYourData(dest,_otherSideIsBigEndian);
     return(int(_allCommands.size()));
 }
 
-int CSimxContainer::getDataStringOfSplitOrGradualCommands(std::vector<char>& dataString,bool otherSideIsBigEndian)
+int CSimxContainer::getDataString(std::vector<char>& dataString,bool otherSideIsBigEndian)
 { // returns the number of commands fetched
+    if (_isInputContainer)
+        return(0); // apply only on output containers
+    dataString.resize(getDataStringSize());
+    return(writeDataString(&dataString[0],otherSideIsBigEndian));
+}
+
+int CSimxContainer::getDataStringOfSplitOrGradualCommandsSize()
+{ // the size getDataStringOfSplitOrGradualCommands/writeDataStringOfSplitOrGradualCommands will produce
+    if (!_isInputContainer)
+        return(0); // apply only on input containers
+    int retVal=0;
+    for (unsigned int i=0;i<_allCommands.size();i++)
+        retVal+=_allCommands[i]->getYourMemorizedSplitDataSize(true);
+    return(retVal);
+}
+
+int CSimxContainer::writeDataStringOfSplitOrGradualCommands(char* dest,bool otherSideIsBigEndian)
+{ // dest must have room for getDataStringOfSplitOrGradualCommandsSize() bytes. Returns the number of commands written
     if (!_isInputContainer)
         return(0); // apply only on input containers
 
     // Take care only of split or gradual commands:
+    // Single compacting pass: kept commands are moved down, in order
     int fetchedCnt=0;
+    unsigned int keptCnt=0;
     for (unsigned int i=0;i<_allCommands.size();i++)
     {
         bool removeCommand=false;
-        if (_allCommands[i]->appendYourMemorizedSplitData(true,dataString,removeCommand,_otherSideIsBigEndian))
+        if (_allCommands[i]->writeYourMemorizedSplitData(true,dest,removeCommand,_otherSideIsBigEndian))
             fetchedCnt++;
         if (removeCommand)
-        {
             delete _allCommands[i];
-            _allCommands.erase(_allCommands.begin()+i);
-            i--; // reprocess this position
-        }
+        else
+            _allCommands[keptCnt++]=_allCommands[i];
+    }
+    if (keptCnt!=_allCommands.size())
+    {
+        _allCommands.resize(keptCnt);
+        _rebuildCommandIndex();
     }
     return(fetchedCnt);
 }
 
+int CSimxContainer::getDataStringOfSplitOrGradualCommands(std::vector<char>& dataString,bool otherSideIsBigEndian)
+{ // returns the number of commands fetched
+    if (!_isInputContainer)
+        return(0); // apply only on input containers
+    size_t off=dataString.size();
+    dataString.resize(off+getDataStringOfSplitOrGradualCommandsSize());
+    char* dest=NULL;
+    if (!dataString.empty())
+        dest=&dataString[0]+off;
+    return(writeDataStringOfSplitOrGradualCommands(dest,otherSideIsBigEndian));
+}
+
 
 int CSimxContainer::getCommandCount()
 {
@@ -1,8 +1,17 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
+#include <map>
 #include "simxCmd.h"
 
+struct SSimxPartialCmd
+{
+    char* data; // fullSize bytes: sub-header, command data and pure data
+    int pureDataStart; // offset of the pure data in data
+    std::map<int,int> receivedRanges; // pure data ranges received so far (start --> end), merged
+};
+
 class CSimxContainer
 {
 public:
@@ -17,7 +26,11 @@ public:
     void executeCommands(CSimxContainer* outputContainer,CSimxSocket* sock);
     void setCommandsAlreadyExecuted(bool e);
     bool getCommandsAlreadyExecuted();
+    int getDataStringSize();
+    int writeDataString(char* dest,bool otherSideIsBigEndian);
     int getDataString(std::vector<char>& dataString,bool otherSideIsBigEndian);
+    int getDataStringOfSplitOrGradualCommandsSize();
+    int writeDataStringOfSplitOrGradualCommands(char* dest,bool otherSideIsBigEndian);
     int getDataStringOfSplitOrGradualCommands(std::vector<char>& dataString,bool otherSideIsBigEndian);
     int getStreamCommandCount();
     void setMessageID(int id);
@@ -32,6 +45,9 @@ public:
 
 protected:
     int _getIndexOfSimilarCommand(CSimxCmd* cmd);
+    unsigned int _getPartialCommandHash(const char* buffer,bool otherSideIsBigEndian);
+    static bool _addReceivedRange(SSimxPartialCmd& partialCmd,int start,int end,int pureDataSize);
+    void _rebuildCommandIndex();
     void _removeNonContinuousCommands();
 
     int _messageID;
@@ -42,5 +58,6 @@ protected:
     bool _isInputContainer;
     bool _otherSideIsBigEndian;
     std::vector<CSimxCmd*> _allCommands;
-    std::vector<char*> _partialCommands;
+    std::unordered_multimap<unsigned int,int> _commandIndex; // input containers only: command+command data hash --> index in _allCommands
+    std::unordered_multimap<unsigned int,SSimxPartialCmd> _partialCommands; // split commands being reassembled, keyed by command+command data hash
 };
@@ -0,0 +1,305 @@
+#include "simxImage.h"
+#include <string.h>
+#include <math.h>
+
+#ifdef SIMX_IMAGE_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define SIMX_TARGET(t) // MSVC compiles intrinsics of any instruction set
+    #else
+        #define SIMX_TARGET(t) __attribute__((target(t)))
+    #endif
+#endif /* SIMX_IMAGE_X86 */
+
+#define SIMX_DIV3_MUL 43691 // (x*43691)>>17 is x/3 for all x<=765 (sum of 3 bytes)
+
+typedef void (*rgbToGrayKernel)(const BYTE* rgb,BYTE* gray,int pixelCount);
+typedef void (*quantizeDepthKernel)(const float* depth,WORD* dest,int count);
+
+static void _convertRgbToGray_scalar(const BYTE* rgb,BYTE* gray,int pixelCount)
+{
+    for (int i=0;i<pixelCount;i++)
+        gray[i]=BYTE((rgb[3*i+0]+rgb[3*i+1]+rgb[3*i+2])/3);
+}
+
+static void _quantizeDepthToWord_scalar(const float* depth,WORD* dest,int count)
+{ // lrintf rounds like the SIMD conversions (to nearest even)
+    for (int i=0;i<count;i++)
+    {
+        float v=depth[i];
+        if (!(v>0.0f))
+            v=0.0f; // also NaN
+        else if (v>1.0f)
+            v=1.0f;
+        dest[i]=WORD(lrintf(v*65535.0f));
+    }
+}
+
+#ifdef SIMX_IMAGE_X86
+
+// pshufb masks gathering the R, G or B bytes of 16 pixels from 3 consecutive 16 byte blocks (-1 yields 0)
+static const signed char _deinterleaveMasks[3][3][16]={
+    { // R
+        {0,3,6,9,12,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+        {-1,-1,-1,-1,-1,-1,2,5,8,11,14,-1,-1,-1,-1,-1},
+        {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,1,4,7,10,13}
+    },
+    { // G
+        {1,4,7,10,13,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+        {-1,-1,-1,-1,-1,0,3,6,9,12,15,-1,-1,-1,-1,-1},
+        {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,2,5,8,11,14}
+    },
+    { // B
+        {2,5,8,11,14,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+        {-1,-1,-1,-1,-1,1,4,7,10,13,-1,-1,-1,-1,-1,-1},
+        {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,0,3,6,9,12,15}
+    }
+};
+
+SIMX_TARGET("ssse3") static __m128i _gray16_ssse3(__m128i a,__m128i b,__m128i c)
+{ // a, b and c hold 16 pixels
+    __m128i zero=_mm_setzero_si128();
+    __m128i div3=_mm_set1_epi16(SIMX_DIV3_MUL);
+    __m128i sumLo=zero;
+    __m128i sumHi=zero;
+    for (int ch=0;ch<3;ch++)
+    {
+        __m128i v=_mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a,_mm_loadu_si128((const __m128i*)_deinterleaveMasks[ch][0])),
+            _mm_shuffle_epi8(b,_mm_loadu_si128((const __m128i*)_deinterleaveMasks[ch][1]))),
+            _mm_shuffle_epi8(c,_mm_loadu_si128((const __m128i*)_deinterleaveMasks[ch][2])));
+        sumLo=_mm_add_epi16(sumLo,_mm_unpacklo_epi8(v,zero));
+        sumHi=_mm_add_epi16(sumHi,_mm_unpackhi_epi8(v,zero));
+    }
+    sumLo=_mm_srli_epi16(_mm_mulhi_epu16(sumLo,div3),1);
+    sumHi=_mm_srli_epi16(_mm_mulhi_epu16(sumHi,div3),1);
+    return(_mm_packus_epi16(sumLo,sumHi));
+}
+
+SIMX_TARGET("ssse3") static void _convertRgbToGray_ssse3(const BYTE* rgb,BYTE* gray,int pixelCount)
+{
+    int i=0;
+    for (;i+16<=pixelCount;i+=16)
+    {
+        const __m128i* src=(const __m128i*)(rgb+3*i);
+        __m128i g=_gray16_ssse3(_mm_loadu_si128(src+0),_mm_loadu_si128(src+1),_mm_loadu_si128(src+2));
+        _mm_storeu_si128((__m128i*)(gray+i),g);
+    }
+    _convertRgbToGray_scalar(rgb+3*i,gray+i,pixelCount-i);
+}
+
+SIMX_TARGET("avx2") static void _convertRgbToGray_avx2(const BYTE* rgb,BYTE* gray,int pixelCount)
+{ // pshufb works within 128 bit lanes: the low lane processes pixels 0-15, the high lane pixels 16-31
+    __m256i zero=_mm256_setzero_si256();
+    __m256i div3=_mm256_set1_epi16(SIMX_DIV3_MUL);
+    __m256i masks[3][3];
+    for (int ch=0;ch<3;ch++)
+    {
+        for (int j=0;j<3;j++)
+            masks[ch][j]=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)_deinterleaveMasks[ch][j]));
+    }
+    int i=0;
+    for (;i+32<=pixelCount;i+=32)
+    {
+        const __m128i* src=(const __m128i*)(rgb+3*i);
+        __m256i a=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(src+0)),_mm_loadu_si128(src+3),1);
+        __m256i b=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(src+1)),_mm_loadu_si128(src+4),1);
+        __m256i c=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(src+2)),_mm_loadu_si128(src+5),1);
+        __m256i sumLo=zero;
+        __m256i sumHi=zero;
+        for (int ch=0;ch<3;ch++)
+        {
+            __m256i v=_mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a,masks[ch][0]),_mm256_shuffle_epi8(b,masks[ch][1])),_mm256_shuffle_epi8(c,masks[ch][2]));
+            sumLo=_mm256_add_epi16(sumLo,_mm256_unpacklo_epi8(v,zero));
+            sumHi=_mm256_add_epi16(sumHi,_mm256_unpackhi_epi8(v,zero));
+        }
+        sumLo=_mm256_srli_epi16(_mm256_mulhi_epu16(sumLo,div3),1);
+        sumHi=_mm256_srli_epi16(_mm256_mulhi_epu16(sumHi,div3),1);
+        _mm256_storeu_si256((__m256i*)(gray+i),_mm256_packus_epi16(sumLo,sumHi)); // packs within lanes: pixel order is kept
+    }
+    _convertRgbToGray_ssse3(rgb+3*i,gray+i,pixelCount-i);
+}
+
+SIMX_TARGET("sse2") static void _quantizeDepthToWord_sse2(const float* depth,WORD* dest,int count)
+{ // SSE2 only packs to signed shorts: values are shifted by 32768 before, and back after packing
+    __m128 zero=_mm_setzero_ps();
+    __m128 one=_mm_set1_ps(1.0f);
+    __m128 scale=_mm_set1_ps(65535.0f);
+    __m128i bias=_mm_set1_epi32(32768);
+    __m128i signBit=_mm_set1_epi16(short(0x8000));
+    int i=0;
+    for (;i+8<=count;i+=8)
+    {
+        __m128 a=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(depth+i+0),zero),one); // max returns its 2nd operand for NaN
+        __m128 b=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(depth+i+4),zero),one);
+        __m128i qa=_mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(a,scale)),bias);
+        __m128i qb=_mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(b,scale)),bias);
+        _mm_storeu_si128((__m128i*)(dest+i),_mm_xor_si128(_mm_packs_epi32(qa,qb),signBit));
+    }
+    _quantizeDepthToWord_scalar(depth+i,dest+i,count-i);
+}
+
+SIMX_TARGET("avx2") static void _quantizeDepthToWord_avx2(const float* depth,WORD* dest,int count)
+{
+    __m256 zero=_mm256_setzero_ps();
+    __m256 one=_mm256_set1_ps(1.0f);
+    __m256 scale=_mm256_set1_ps(65535.0f);
+    int i=0;
+    for (;i+16<=count;i+=16)
+    {
+        __m256 a=_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(depth+i+0),zero),one);
+        __m256 b=_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(depth+i+8),zero),one);
+        __m256i q=_mm256_packus_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(a,scale)),_mm256_cvtps_epi32(_mm256_mul_ps(b,scale)));
+        _mm256_storeu_si256((__m256i*)(dest+i),_mm256_permute4x64_epi64(q,0xd8)); // packs within lanes: restore the order
+    }
+    _quantizeDepthToWord_sse2(depth+i,dest+i,count-i);
+}
+
+static int _getCpuLevel()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info,0);
+    int maxLeaf=info[0];
+    __cpuid(info,1);
+    int level=SIMX_CPU_SCALAR;
+    if ((info[3]&(1<<26))!=0)
+        level=SIMX_CPU_SSE2;
+    if ((info[2]&(1<<9))!=0)
+        level=SIMX_CPU_SSSE3;
+    bool osSavesAvx=((info[2]&(1<<27))!=0)&&((info[2]&(1<<28))!=0)&&((_xgetbv(0)&6)==6);
+    if (osSavesAvx&&(maxLeaf>=7))
+    {
+        __cpuidex(info,7,0);
+        if ((info[1]&(1<<5))!=0)
+            level=SIMX_CPU_AVX2;
+    }
+    return(level);
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return(SIMX_CPU_AVX2);
+    if (__builtin_cpu_supports("ssse3"))
+        return(SIMX_CPU_SSSE3);
+    if (__builtin_cpu_supports("sse2"))
+        return(SIMX_CPU_SSE2);
+    return(SIMX_CPU_SCALAR);
+#endif
+}
+
+#else
+
+static int _getCpuLevel()
+{
+    return(SIMX_CPU_SCALAR);
+}
+
+#endif /* SIMX_IMAGE_X86 */
+
+// Kernels are selected at load time, not lazily from several threads:
+static int _cpuLevel=_getCpuLevel();
+
+static rgbToGrayKernel _selectRgbToGrayKernel(int level)
+{
+#ifdef SIMX_IMAGE_X86
+    if (level>=SIMX_CPU_AVX2)
+        return(_convertRgbToGray_avx2);
+    if (level>=SIMX_CPU_SSSE3)
+        return(_convertRgbToGray_ssse3);
+#endif /* SIMX_IMAGE_X86 */
+    return(_convertRgbToGray_scalar);
+}
+
+static quantizeDepthKernel _selectQuantizeDepthKernel(int level)
+{
+#ifdef SIMX_IMAGE_X86
+    if (level>=SIMX_CPU_AVX2)
+        return(_quantizeDepthToWord_avx2);
+    if (level>=SIMX_CPU_SSE2)
+        return(_quantizeDepthToWord_sse2);
+#endif /* SIMX_IMAGE_X86 */
+    return(_quantizeDepthToWord_scalar);
+}
+
+static rgbToGrayKernel _rgbToGray=_selectRgbToGrayKernel(_cpuLevel);
+static quantizeDepthKernel _quantizeDepth=_selectQuantizeDepthKernel(_cpuLevel);
+
+int setImageKernelLevel(int level)
+{
+    if (level>_cpuLevel)
+        level=_cpuLevel;
+    _rgbToGray=_selectRgbToGrayKernel(level);
+    _quantizeDepth=_selectQuantizeDepthKernel(level);
+    return(level);
+}
+
+void convertRgbToGray(const BYTE* rgb,BYTE* gray,int pixelCount)
+{
+    _rgbToGray(rgb,gray,pixelCount);
+}
+
+void quantizeDepthToWord(const float* depth,WORD* dest,int count)
+{
+    _quantizeDepth(depth,dest,count);
+}
+
+void extractImageRegion(const BYTE* rgb,int imageWidth,int x,int y,int width,int height,int factor,bool gray,BYTE* dest)
+{
+    if (factor==1)
+    { // row copies
+        for (int j=0;j<height;j++)
+        {
+            const BYTE* row=rgb+3*((y+j)*imageWidth+x);
+            if (gray)
+                convertRgbToGray(row,dest+j*width,width);
+            else
+                memcpy(dest+3*j*width,row,3*width);
+        }
+        return;
+    }
+    int outWidth=width/factor;
+    int outHeight=height/factor;
+    int blockSize=factor*factor;
+    for (int j=0;j<outHeight;j++)
+    {
+        for (int i=0;i<outWidth;i++)
+        {
+            int sum[3]={0,0,0};
+            for (int bj=0;bj<factor;bj++)
+            {
+                const BYTE* p=rgb+3*((y+j*factor+bj)*imageWidth+x+i*factor);
+                for (int bi=0;bi<3*factor;bi+=3)
+                {
+                    sum[0]+=p[bi+0];
+                    sum[1]+=p[bi+1];
+                    sum[2]+=p[bi+2];
+                }
+            }
+            if (gray)
+                dest[j*outWidth+i]=BYTE((sum[0]+sum[1]+sum[2])/(3*blockSize));
+            else
+            {
+                for (int c=0;c<3;c++)
+                    dest[3*(j*outWidth+i)+c]=BYTE(sum[c]/blockSize);
+            }
+        }
+    }
+}
+
+void extractDepthRegion(const float* depth,int imageWidth,int x,int y,int width,int height,int factor,float* dest)
+{ // averaging would invent depths at object edges: we take the first value of each block
+    int outWidth=width/factor;
+    int outHeight=height/factor;
+    for (int j=0;j<outHeight;j++)
+    {
+        const float* row=depth+(y+j*factor)*imageWidth+x;
+        if (factor==1)
+            memcpy(dest+j*outWidth,row,outWidth*sizeof(float));
+        else
+        {
+            for (int i=0;i<outWidth;i++)
+                dest[j*outWidth+i]=row[i*factor];
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "porting.h"
+
+#if defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)
+    #define SIMX_IMAGE_X86 // SSE2, SSSE3 and AVX2 kernels, selected at run time
+#endif
+
+#define SIMX_CPU_SCALAR 0
+#define SIMX_CPU_SSE2   1
+#define SIMX_CPU_SSSE3  2
+#define SIMX_CPU_AVX2   3
+
+// gray[i]=(r+g+b)/3. The kernel is selected once, according to the CPU
+void convertRgbToGray(const BYTE* rgb,BYTE* gray,int pixelCount);
+
+// dest[i]=depth[i]*65535, rounded to nearest even. Depth values are clamped to [0;1] (NaN gives 0). Same kernel selection
+void quantizeDepthToWord(const float* depth,WORD* dest,int count);
+
+// Selects the kernels of a lower SIMX_CPU_x level (clamped to what the CPU supports) and returns the level now in use.
+// For benchmarks and checks only: not thread-safe
+int setImageKernelLevel(int level);
+
+// Region of interest (x, y, width, height in pixels of the image) downsampled by an integer factor. dest receives
+// (width/factor)*(height/factor) values. Image blocks of factor*factor pixels are averaged, depth blocks are subsampled
+void extractImageRegion(const BYTE* rgb,int imageWidth,int x,int y,int width,int height,int factor,bool gray,BYTE* dest);
+void extractDepthRegion(const float* depth,int imageWidth,int x,int y,int width,int height,int factor,float* dest);
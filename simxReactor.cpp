@@ -0,0 +1,301 @@
+#include "simxReactor.h"
+
+#if defined (__linux)
+
+#include "simxSocket.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+
+#define REACTOR_MAX_EVENTS 64
+#define REACTOR_DEFERRED_POLL_INTERVAL 1 // in ms. How often deferred sockets are checked
+
+CSimxReactor::CSimxReactor()
+{
+    _epollFd=-1;
+    _wakeFd=-1;
+    _running=false;
+    _hasDeferred=false;
+    _servingSock=NULL;
+    pthread_mutex_init(&_mutex,NULL);
+    pthread_cond_init(&_servingDone,NULL);
+}
+
+CSimxReactor::~CSimxReactor()
+{
+    stop();
+    pthread_cond_destroy(&_servingDone);
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool CSimxReactor::_start()
+{
+    if (_running)
+        return(true);
+    _epollFd=epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd==-1)
+        return(false);
+    _wakeFd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if (_wakeFd==-1)
+    {
+        close(_epollFd);
+        _epollFd=-1;
+        return(false);
+    }
+    struct epoll_event ev;
+    ev.events=EPOLLIN;
+    ev.data.fd=_wakeFd;
+    epoll_ctl(_epollFd,EPOLL_CTL_ADD,_wakeFd,&ev);
+    _running=true;
+    if (pthread_create(&_theThread,NULL,&CSimxReactor::_staticThreadProc,this)!=0)
+    {
+        _running=false;
+        close(_wakeFd);
+        close(_epollFd);
+        _wakeFd=-1;
+        _epollFd=-1;
+        return(false);
+    }
+    return(true);
+}
+
+void CSimxReactor::stop()
+{
+    if (!_running)
+        return;
+    _running=false;
+    unsigned long long one=1;
+    if (write(_wakeFd,&one,sizeof(one))) {} // unblock epoll_wait
+    pthread_join(_theThread,NULL);
+    close(_wakeFd);
+    close(_epollFd);
+    _wakeFd=-1;
+    _epollFd=-1;
+    _watchedSockets.clear();
+    _hasDeferred=false;
+}
+
+bool CSimxReactor::addSocket(CSimxSocket* sock)
+{ // the socket must already be listening (see CSimxSocket::start)
+    if (sock->getListeningSocket()==INVALID_SOCKET)
+        return(false);
+    pthread_mutex_lock(&_mutex);
+    bool retVal=_start();
+    if (retVal)
+        _watch(sock->getListeningSocket(),sock,true);
+    pthread_mutex_unlock(&_mutex);
+    return(retVal);
+}
+
+void CSimxReactor::removeSocket(CSimxSocket* sock)
+{ // Once this returns, the reactor thread won't touch sock anymore. We only wait for a call into sock that is in progress
+    pthread_mutex_lock(&_mutex);
+    std::map<int,SWatchedSocket>::iterator it=_watchedSockets.begin();
+    while (it!=_watchedSockets.end())
+    {
+        if (it->second.sock==sock)
+        {
+            epoll_ctl(_epollFd,EPOLL_CTL_DEL,it->first,NULL);
+            _watchedSockets.erase(it++);
+        }
+        else
+            ++it;
+    }
+    while (_servingSock==sock)
+        pthread_cond_wait(&_servingDone,&_mutex);
+    pthread_mutex_unlock(&_mutex);
+}
+
+bool CSimxReactor::_isWatched(int fd,CSimxSocket* sock)
+{ // _mutex is locked here. False if the socket was removed while we were calling into it
+    std::map<int,SWatchedSocket>::iterator it=_watchedSockets.find(fd);
+    return( (it!=_watchedSockets.end())&&(it->second.sock==sock) );
+}
+
+void CSimxReactor::_watch(int fd,CSimxSocket* sock,bool listening)
+{
+    struct epoll_event ev;
+    ev.events=EPOLLIN|EPOLLRDHUP;
+    ev.data.fd=fd;
+    if (epoll_ctl(_epollFd,EPOLL_CTL_ADD,fd,&ev)==0)
+    {
+        SWatchedSocket w;
+        w.sock=sock;
+        w.listening=listening;
+        w.accepting=true;
+        w.writing=false;
+        w.deferred=false;
+        _watchedSockets[fd]=w;
+    }
+}
+
+void CSimxReactor::_unwatch(int fd)
+{
+    epoll_ctl(_epollFd,EPOLL_CTL_DEL,fd,NULL);
+    _watchedSockets.erase(fd);
+}
+
+void CSimxReactor::_updateEvents(int fd,const SWatchedSocket& w)
+{ // Without EPOLLRDHUP while writing: a hang-up would be signalled over and over, since we don't read. A closed socket fails the send anyway
+    struct epoll_event ev;
+    ev.events=0;
+    if (!w.deferred)
+    {
+        if (w.listening)
+        {
+            if (w.accepting)
+                ev.events=EPOLLIN;
+        }
+        else if (w.writing)
+            ev.events=EPOLLOUT;
+        else
+            ev.events=EPOLLIN|EPOLLRDHUP;
+    }
+    ev.data.fd=fd;
+    epoll_ctl(_epollFd,EPOLL_CTL_MOD,fd,&ev);
+}
+
+void CSimxReactor::_setWriting(int fd,bool writing)
+{
+    std::map<int,SWatchedSocket>::iterator it=_watchedSockets.find(fd);
+    if ( (it==_watchedSockets.end())||(it->second.writing==writing) )
+        return;
+    it->second.writing=writing;
+    _updateEvents(fd,it->second);
+}
+
+void CSimxReactor::_enableListening(CSimxSocket* sock,bool enable)
+{ // When a port can't take more clients, pending clients stay in the listen backlog (like with the threaded routines)
+    int fd=sock->getListeningSocket();
+    std::map<int,SWatchedSocket>::iterator it=_watchedSockets.find(fd);
+    if ( (it==_watchedSockets.end())||(it->second.sock!=sock)||(it->second.accepting==enable) )
+        return;
+    it->second.accepting=enable;
+    _updateEvents(fd,it->second);
+}
+
+void CSimxReactor::_handleEvent(int fd,unsigned int events)
+{ // _mutex is not locked here. We don't keep it locked while calling into a socket: serving a client has to wait
+  // for CSimxSocket::_lock, and adding or removing other sockets must not wait for that
+    pthread_mutex_lock(&_mutex);
+    std::map<int,SWatchedSocket>::iterator it=_watchedSockets.find(fd);
+    if (it==_watchedSockets.end())
+    { // the socket was removed in the mean time
+        pthread_mutex_unlock(&_mutex);
+        return;
+    }
+    CSimxSocket* sock=it->second.sock;
+    if (sock->getIsExecutingCommands())
+    { // the main thread holds the socket's lock: serve the other sockets first, and come back to this one later
+        it->second.deferred=true;
+        _updateEvents(fd,it->second);
+        _hasDeferred=true;
+        pthread_mutex_unlock(&_mutex);
+        return;
+    }
+    bool listening=it->second.listening;
+    _servingSock=sock; // sock can't be deleted until we clear this (see removeSocket)
+    pthread_mutex_unlock(&_mutex);
+
+    if (listening)
+    {
+        _SOCKET clientSocket=sock->acceptClient();
+        bool accepts=sock->getAcceptsMoreClients();
+        pthread_mutex_lock(&_mutex);
+        if (_isWatched(fd,sock))
+        {
+            if (clientSocket!=INVALID_SOCKET)
+                _watch(clientSocket,sock,false);
+            _enableListening(sock,accepts);
+        }
+    }
+    else
+    { // replies are sent without blocking: a slow client only delays itself
+        bool keep=true;
+        if ((events&EPOLLOUT)!=0)
+            keep=sock->sendUnsentReply(fd);
+        if (keep&&(!sock->getClientHasUnsentReply(fd)))
+            keep=sock->serveClient(fd); // serve what arrived before a hang-up too, or while a reply was pending
+        if ( (!keep)||((events&(EPOLLERR|EPOLLHUP))!=0) )
+        {
+            pthread_mutex_lock(&_mutex);
+            bool watched=_isWatched(fd,sock);
+            if (watched)
+                _unwatch(fd); // before the socket is closed
+            pthread_mutex_unlock(&_mutex);
+            if (watched)
+                sock->disconnectClient(fd);
+            bool accepts=sock->getAcceptsMoreClients();
+            pthread_mutex_lock(&_mutex);
+            _enableListening(sock,accepts);
+        }
+        else
+        {
+            bool writing=sock->getClientHasUnsentReply(fd);
+            pthread_mutex_lock(&_mutex);
+            if (_isWatched(fd,sock))
+                _setWriting(fd,writing);
+        }
+    }
+    _servingSock=NULL;
+    pthread_cond_broadcast(&_servingDone);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void CSimxReactor::_resumeDeferred()
+{ // Deferred sockets are polled again once the main thread is done with them. Level-triggered: pending events are reported again
+    pthread_mutex_lock(&_mutex);
+    _hasDeferred=false;
+    for (std::map<int,SWatchedSocket>::iterator it=_watchedSockets.begin();it!=_watchedSockets.end();++it)
+    {
+        if (it->second.deferred)
+        {
+            if (it->second.sock->getIsExecutingCommands())
+                _hasDeferred=true;
+            else
+            {
+                it->second.deferred=false;
+                _updateEvents(it->first,it->second);
+            }
+        }
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void* CSimxReactor::_staticThreadProc(void* arg)
+{
+    return(reinterpret_cast<CSimxReactor*>(arg)->_run());
+}
+
+void* CSimxReactor::_run()
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    while (_running)
+    {
+        int timeout=-1;
+        if (_hasDeferred)
+            timeout=REACTOR_DEFERRED_POLL_INTERVAL;
+        int cnt=epoll_wait(_epollFd,events,REACTOR_MAX_EVENTS,timeout);
+        if (cnt<0)
+        {
+            if (errno==EINTR)
+                continue;
+            break;
+        }
+        if (_hasDeferred)
+            _resumeDeferred();
+        for (int i=0;i<cnt;i++)
+        {
+            if (events[i].data.fd==_wakeFd)
+            {
+                unsigned long long v;
+                if (read(_wakeFd,&v,sizeof(v))) {}
+            }
+            else
+                _handleEvent(events[i].data.fd,events[i].events);
+        }
+    }
+    return(NULL);
+}
+
+#endif /* __linux */
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "porting.h"
+
+#if defined (__linux)
+
+#include <map>
+#include <pthread.h>
+
+class CSimxSocket; // forward declaration
+
+// One epoll thread serving the listening and client sockets of all event loop mode CSimxSocket objects
+class CSimxReactor
+{
+public:
+    CSimxReactor();
+    virtual ~CSimxReactor();
+
+    bool addSocket(CSimxSocket* sock);
+    void removeSocket(CSimxSocket* sock);
+    void stop();
+
+protected:
+    struct SWatchedSocket
+    {
+        CSimxSocket* sock;
+        bool listening;
+        bool accepting; // listening sockets: the port takes more clients
+        bool writing; // client sockets: we wait until the socket is writable (a reply is pending), instead of reading
+        bool deferred; // not polled while the main thread executes the commands of sock (see _resumeDeferred)
+    };
+
+    bool _start();
+    void* _run();
+    static void* _staticThreadProc(void* arg);
+    void _handleEvent(int fd,unsigned int events);
+    void _resumeDeferred();
+    bool _isWatched(int fd,CSimxSocket* sock);
+    void _watch(int fd,CSimxSocket* sock,bool listening);
+    void _unwatch(int fd);
+    void _updateEvents(int fd,const SWatchedSocket& w);
+    void _setWriting(int fd,bool writing);
+    void _enableListening(CSimxSocket* sock,bool enable);
+
+    int _epollFd;
+    int _wakeFd;
+    volatile bool _running;
+    bool _hasDeferred;
+    std::map<int,SWatchedSocket> _watchedSockets;
+    CSimxSocket* _servingSock; // the socket the reactor thread is calling into, without _mutex locked
+    pthread_t _theThread;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _servingDone;
+};
+
+#endif /* __linux */
@@ -5,6 +5,7 @@
 #include <sstream>
 
 bool CSimxSocket::useAlternateSocketRoutines=false;
+bool CSimxSocket::useEventLoop=false;
 
 
 CSimxSocket::CSimxSocket(int portNb,bool continuousService,bool simulationOnly,bool debug,int maxPacketSize,bool waitForTriggerFunctionAuthorized)
@@ -22,6 +23,20 @@ CSimxSocket::CSimxSocket(int portNb,bool continuousService,bool simulationOnly,b
     _waitForTrigger=true;
     _waitForTriggerFunctionEnabled=false;
     _waitForTriggerFunctionAuthorized=waitForTriggerFunctionAuthorized;
+    connection=NULL;
+    _previousReceivedMessage_time=0;
+    _lastListenAttemptTime=0;
+    _executingCommands=false;
+    _multiClient=false;
+    _socketOptions.noDelay=false;
+    _socketOptions.quickAck=false;
+    _socketOptions.rcvBuf=0;
+    _socketOptions.sndBuf=0;
+#if defined (__linux)
+    _eventLoopMode=useEventLoop&&(_portNb>=0); // shared memory ports always have their own thread
+#else
+    _eventLoopMode=false;
+#endif /* __linux */
     if (debug)
     {
         int options=4;
@@ -129,7 +144,16 @@ void CSimxSocket::start()
         _successiveReception_time=0;
         _lastReceivedMessage_cmdCnt=0;
         _lastSentMessage_cmdCnt=0;
+        _lastSentMessage_syscallCnt=0;
 
+#if defined (__linux) || defined (__APPLE__)
+        if (_eventLoopMode)
+        { // no thread here: CSimxReactor polls our sockets once we were added to the connections
+            if (!_startListening())
+                std::cout << "Failed listening on port " << _portNb << ", retrying every " << SIMX_LISTEN_RETRY_INTERVAL << " ms" << std::endl;
+            return;
+        }
+#endif /* __linux || __APPLE__ */
         _commThreadEnded=false;
 #ifdef _WIN32
         CreateThread(NULL,0,&CSimxSocket::_staticThreadProc,this,THREAD_PRIORITY_NORMAL,NULL);
@@ -142,6 +166,32 @@ void CSimxSocket::start()
     }
 }
 
+#if defined (__linux) || defined (__APPLE__)
+bool CSimxSocket::_startListening()
+{ // event loop mode. Like the threaded mode, we keep trying if the port is not available (e.g. still in TIME_WAIT)
+    _lastListenAttemptTime=getTimeInMs();
+    connection=new CInConnection(_portNb,_maxPacketSize,true);
+    if (_unixSocketPath.length()!=0)
+        connection->setUnixSocketPath(_unixSocketPath.c_str());
+    connection->setSocketOptions(_socketOptions);
+    if (connection->startListening())
+        return(true);
+    delete connection;
+    connection=NULL;
+    return(false);
+}
+
+bool CSimxSocket::retryListening()
+{ // event loop mode, called from the main thread. True if we just started listening: the socket can then be added to the reactor
+    if ( (!_eventLoopMode)||(connection!=NULL)||(getTimeDiffInMs(_lastListenAttemptTime)<SIMX_LISTEN_RETRY_INTERVAL) )
+        return(false);
+    if (!_startListening())
+        return(false);
+    std::cout << "Listening on port " << _portNb << " now" << std::endl;
+    return(true);
+}
+#endif /* __linux || __APPLE__ */
+
 void CSimxSocket::_stop()
 {
     // Terminate the communication thread if needed:
@@ -171,6 +221,22 @@ void CSimxSocket::_stop()
         {   // no, the communication thread is probably waiting for a connection (blocked while accepting)
 
             // Make a fake connection to this socket, to unblock it (the thread might be trapped in the "accept" function)
+#if defined (__linux) || defined (__APPLE__)
+            if ( (_portNb>=0)&&(_unixSocketPath.length()!=0) )
+            { // Unix domain socket
+                _SOCKET _socketConn=socket(AF_UNIX,SOCK_STREAM,0);
+                if (_socketConn!=INVALID_SOCKET)
+                {
+                    struct sockaddr_un addr;
+                    memset(&addr,0,sizeof(addr));
+                    addr.sun_family=AF_UNIX;
+                    strncpy(addr.sun_path,_unixSocketPath.c_str(),sizeof(addr.sun_path)-1);
+                    connect(_socketConn,(struct sockaddr*)&addr,sizeof(addr));
+                    close(_socketConn);
+                }
+            }
+            else
+#endif /* __linux || __APPLE__ */
             if (_portNb>=0)
             { // sockets
                 struct hostent *hp;
@@ -218,18 +284,31 @@ void CSimxSocket::_stop()
 
     }
 
+    if (_eventLoopMode)
+    { // CSimxConnections already removed us from the reactor
+        _lock();
+        for (unsigned int i=0;i<_clients.size();i++)
+            _deleteClient(_clients[i]);
+        _clients.clear();
+        _unlock();
+        delete connection;
+        connection=NULL;
+        clientIsConnected=false;
+    }
+
     // Do some other clean-up:
     _receivedCommands->clearAll();
     _dataToSend->clearAll();
 }
 
-void CSimxSocket::getInfo(int info[5])
+void CSimxSocket::getInfo(int info[6])
 {
     info[0]=_lastReceivedMessage_time;
     info[1]=_lastSentMessage_time;
     info[2]=_successiveReception_time;
     info[3]=_lastReceivedMessage_cmdCnt;
     info[4]=_lastSentMessage_cmdCnt;
+    info[5]=_lastSentMessage_syscallCnt;
 }
 
 int CSimxSocket::getClientVersion()
@@ -240,7 +319,7 @@ int CSimxSocket::getClientVersion()
 int CSimxSocket::getStatus()
 {
     int retVal=0;
-    if (_commThreadLaunched)
+    if (_commThreadLaunched||(_eventLoopMode&&(connection!=NULL)))
         retVal|=1;
     if (clientIsConnected)
         retVal|=2;
@@ -272,6 +351,175 @@ int CSimxSocket::getMaxPacketSize()
     return(_maxPacketSize);
 }
 
+bool CSimxSocket::getUsesEventLoop()
+{
+    return(_eventLoopMode);
+}
+
+void CSimxSocket::setMultiClient(bool m)
+{ // call before start(). Several clients can only share a port in event loop mode (Linux, not with shared memory). Ignored otherwise
+#if defined (__linux)
+    _multiClient=m&&(_portNb>=0);
+    _eventLoopMode=(useEventLoop||_multiClient)&&(_portNb>=0);
+#endif /* __linux */
+}
+
+bool CSimxSocket::getMultiClient()
+{
+    return(_multiClient);
+}
+
+void CSimxSocket::setUnixSocketPath(const char* path)
+{ // call before start(). Clients then connect to that Unix domain socket instead of the TCP port (ignored on Windows)
+    _unixSocketPath=path;
+}
+
+std::string CSimxSocket::getUnixSocketPath()
+{
+    return(_unixSocketPath);
+}
+
+void CSimxSocket::setSocketOptions(const SSocketOptions& options)
+{ // call before start()
+    _socketOptions=options;
+}
+
+SSocketOptions CSimxSocket::getSocketOptions()
+{
+    return(_socketOptions);
+}
+
+#if defined (__linux) || defined (__APPLE__)
+_SOCKET CSimxSocket::getListeningSocket()
+{
+    if (connection==NULL)
+        return(INVALID_SOCKET);
+    return(connection->getListeningSocket());
+}
+
+bool CSimxSocket::getAcceptsMoreClients()
+{
+    return(_multiClient||(_clients.size()==0));
+}
+
+_SOCKET CSimxSocket::acceptClient()
+{ // called from the reactor thread. Returns the socket of the new client
+    if ( (connection==NULL)||(!getAcceptsMoreClients()) )
+        return(INVALID_SOCKET);
+    CInConnection* clientConnection=connection->acceptNewClient();
+    if (clientConnection==NULL)
+        return(INVALID_SOCKET);
+    SSimxClient* client=new SSimxClient;
+    client->connection=clientConnection;
+    client->receivedCommands=new CSimxContainer(true);
+    client->dataToSend=new CSimxContainer(false);
+    _lock();
+    _clients.push_back(client);
+    clientIsConnected=true;
+    if (_debug)
+    {
+        std::stringstream strStream;
+        strStream << "connected to client (" << clientConnection->getConnectedMachineIP() << ").\n";
+        _textToPrintToConsole.push_back(strStream.str());
+    }
+    _unlock();
+    return(clientConnection->getClientSocket());
+}
+
+bool CSimxSocket::serveClient(_SOCKET s)
+{ // called from the reactor thread, when the client socket is readable. Return value false means: disconnect the client
+  // We stop reading as soon as a reply couldn't be sent entirely: the client is served again once it took the reply
+    int index=_getClientIndex(s);
+    if (index==-1)
+        return(false);
+    SSimxClient* client=_clients[index]; // only the reactor thread adds or removes clients
+    while (!client->connection->hasUnsentReply())
+    {
+        int dataSize;
+        char* data=client->connection->receiveMessageIfAvailable(dataSize);
+        if (dataSize==0)
+            return(true); // wait for more data
+        if (dataSize<0)
+        {
+            if (_debug)
+            { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
+                _lock(); // important to lock resources!
+                _textToPrintToConsole.push_back("error while receiving data.\n");
+                _unlock();
+            }
+            return(false);
+        }
+        if (!_serveMessage(client->connection,client->receivedCommands,client->dataToSend,data,dataSize))
+            return(false);
+    }
+    return(true);
+}
+
+bool CSimxSocket::sendUnsentReply(_SOCKET s)
+{ // called from the reactor thread, when the client socket is writable. Return value false means: disconnect the client
+    int index=_getClientIndex(s);
+    if (index==-1)
+        return(false);
+    if (_clients[index]->connection->sendUnsentReply())
+        return(true);
+    if (_debug)
+    { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
+        _lock(); // important to lock resources!
+        _textToPrintToConsole.push_back("failed sending reply.\n");
+        _unlock();
+    }
+    return(false);
+}
+
+bool CSimxSocket::getIsExecutingCommands()
+{ // the reactor thread may still find it false just before the main thread takes the lock: it then waits for one pass, as before
+    return(_executingCommands);
+}
+
+bool CSimxSocket::getClientHasUnsentReply(_SOCKET s)
+{
+    int index=_getClientIndex(s);
+    return((index!=-1)&&_clients[index]->connection->hasUnsentReply());
+}
+
+void CSimxSocket::disconnectClient(_SOCKET s)
+{ // called from the reactor thread, after it stopped polling the client socket
+    int index=_getClientIndex(s);
+    if (index==-1)
+        return;
+    _lock();
+    _deleteClient(_clients[index]);
+    _clients.erase(_clients.begin()+index);
+    clientIsConnected=(_clients.size()!=0);
+    if (_debug)
+        _textToPrintToConsole.push_back("disconnected from client.\n");
+    _unlock();
+    if (!clientIsConnected)
+    {
+        _waitForTrigger=true;
+        _waitForTriggerFunctionEnabled=false;
+    }
+}
+#endif /* __linux || __APPLE__ */
+
+int CSimxSocket::_getClientIndex(_SOCKET s)
+{
+    for (unsigned int i=0;i<_clients.size();i++)
+    {
+        if (_clients[i]->connection->getClientSocket()==s)
+            return((int)i);
+    }
+    return(-1);
+}
+
+void CSimxSocket::_deleteClient(SSimxClient* client)
+{
+    delete client->connection; // this also closes the client socket
+    delete client->receivedCommands;
+    delete client->dataToSend;
+    delete client;
+}
+
 void CSimxSocket::_simpleLock(MUTEX_HANDLE_X mutex)
 {
 #ifdef _WIN32
@@ -354,9 +602,17 @@ void CSimxSocket::_unlock()
 
 void CSimxSocket::_executeCommands()
 {
+    _executingCommands=true; // the reactor thread serves other sockets meanwhile, instead of waiting for the lock
     _lock();
-    _receivedCommands->executeCommands(_dataToSend,this);
+    if (_eventLoopMode)
+    { // all clients are served in the same pass
+        for (unsigned int i=0;i<_clients.size();i++)
+            _clients[i]->receivedCommands->executeCommands(_clients[i]->dataToSend,this);
+    }
+    else
+        _receivedCommands->executeCommands(_dataToSend,this);
     _unlock();
+    _executingCommands=false;
 }
 
 void* CSimxSocket::_run()
@@ -366,6 +622,11 @@ void* CSimxSocket::_run()
     while (_commThreadLaunched)
     {
         connection=new CInConnection(_portNb,_maxPacketSize,useAlternateSocketRoutines);
+#if defined (__linux) || defined (__APPLE__)
+        if ( (_portNb>=0)&&(_unixSocketPath.length()!=0) )
+            connection->setUnixSocketPath(_unixSocketPath.c_str());
+#endif /* __linux || __APPLE__ */
+        connection->setSocketOptions(_socketOptions);
         if (_debug)
         { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
             _lock();
@@ -381,13 +642,13 @@ void* CSimxSocket::_run()
             _receivedCommands->clearAll();
             _dataToSend->clearAll();
             _unlock();
-            int _lastLastReceivedMessage_time=0;
             if (_debug)
             { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
                 _lock(); // we are not locked here!
                 _textToPrintToConsole.push_back("connected to client.\n");
                 _unlock();
             }
+            _previousReceivedMessage_time=0;
             while (_commThreadLaunched)
             {
                 int dataSize;
@@ -396,117 +657,8 @@ void* CSimxSocket::_run()
                 if (dataSize>0)
                 { // we received some data. The server ALWAYS replies!
 //printf("Read successful!\n");
-                    _lastReceivedMessage_time=getTimeInMs();
-                    _successiveReception_time=_lastReceivedMessage_time-_lastLastReceivedMessage_time;
-                    _lastLastReceivedMessage_time=_lastReceivedMessage_time;
-
-                    otherSideIsBigEndian=connection->isOtherSideBigEndian();
-                    // a) check the CRC:
-                    WORD crc=littleEndianWordConversion(((WORD*)(data+simx_headeroffset_crc))[0],otherSideIsBigEndian);
-                    _lock();
-                    _lastReceivedMessage_cmdCnt=0;
-                    bool killConnectionCommand=false;
-                    // CRC calculation represents a bottleneck for large transmissions, and is anyway not needed with tcp or shared memory transmissions
-                    // if (getCRC(data+2,dataSize-2)==crc)
-                    if (true)
-                    {
-                        _lastReceivedMessage_clientVersion=data[simx_headeroffset_version];
-                        _receivedCommands->setOtherSideIsBigEndian(otherSideIsBigEndian);
-                        _dataToSend->setOtherSideIsBigEndian(otherSideIsBigEndian);
-                        int messageID=littleEndianIntConversion(((int*)(data+simx_headeroffset_message_id))[0],otherSideIsBigEndian);
-                        int timeStamp=littleEndianIntConversion(((int*)(data+simx_headeroffset_client_time))[0],otherSideIsBigEndian);
-                        _receivedCommands->setMessageID(messageID);
-                        _receivedCommands->setDataTimeStamp(timeStamp);
-                        if (_debug)
-                        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
-                            // resources are already locked here, no need to lock a second time!
-                            std::stringstream strStream;
-                            strStream << "data received: " << dataSize << " bytes (message ID = " << messageID << ")\n";
-                            _textToPrintToConsole.push_back(strStream.str());
-                        }
-                        int off=SIMX_HEADER_SIZE;
-                        while (off<dataSize)
-                        {
-                            int cmdSize=littleEndianIntConversion(((int*)(data+off+simx_cmdheaderoffset_mem_size))[0],otherSideIsBigEndian);
-                            int fullCmdSize=littleEndianIntConversion(((int*)(data+off+simx_cmdheaderoffset_full_mem_size))[0],otherSideIsBigEndian);
-                            if (cmdSize!=fullCmdSize)
-                            {
-                                char* fullCommand=_receivedCommands->addPartialCommand(data+off,otherSideIsBigEndian);
-                                if (fullCommand!=NULL)
-                                {
-                                    int localCmdSize=littleEndianIntConversion(((int*)(fullCommand+simx_cmdheaderoffset_mem_size))[0],otherSideIsBigEndian);
-                                    int cmd=littleEndianIntConversion(((int*)(fullCommand+simx_cmdheaderoffset_cmd))[0],otherSideIsBigEndian);
-                                    killConnectionCommand=(cmd==simx_cmd_kill_connection);
-                                    BYTE options=fullCommand[simx_cmdheaderoffset_status]; // bit0 set: do not overwrite this command!
-                                    WORD delayOrSplit=littleEndianWordConversion(((WORD*)(fullCommand+simx_cmdheaderoffset_delay_or_split))[0],otherSideIsBigEndian);
-                                    CSimxCmd* newCmd=new CSimxCmd(cmd,delayOrSplit,localCmdSize-SIMX_SUBHEADER_SIZE,fullCommand+SIMX_SUBHEADER_SIZE);
-                                    _receivedCommands->addCommand(newCmd,options&1);
-                                    delete[] fullCommand;
-                                }
-                            }
-                            else
-                            {
-                                int cmd=littleEndianIntConversion(((int*)(data+off+simx_cmdheaderoffset_cmd))[0],otherSideIsBigEndian);
-                                killConnectionCommand=(cmd==simx_cmd_kill_connection);
-                                BYTE options=data[off+simx_cmdheaderoffset_status]; // bit0 set: do not overwrite this command!
-                                WORD delayOrSplit=littleEndianWordConversion(((WORD*)(data+off+simx_cmdheaderoffset_delay_or_split))[0],otherSideIsBigEndian);
-                                CSimxCmd* newCmd=new CSimxCmd(cmd,delayOrSplit,cmdSize-SIMX_SUBHEADER_SIZE,data+off+SIMX_SUBHEADER_SIZE);
-                                _receivedCommands->addCommand(newCmd,options&1);
-                            }
-                            off+=cmdSize;
-                            _lastReceivedMessage_cmdCnt++;
-                        }
-                    }
-                    else
-                    {
-                        if (_debug)
-                        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
-                            // resources are already locked here, no need to lock a second time!
-                            _textToPrintToConsole.push_back("data received: error (crc failed)\n");
-                        }
-                    }
-                    delete[] data;
-                    // Prepare the reply:
-                    int streamCmdCnt=_dataToSend->getStreamCommandCount();
-                    std::vector<char> replyData;
-                    _lastSentMessage_cmdCnt=_dataToSend->getDataString(replyData,otherSideIsBigEndian);
-                    _lastSentMessage_cmdCnt+=_receivedCommands->getDataStringOfSplitOrGradualCommands(replyData,otherSideIsBigEndian);
-                    int messageIdToSend=_dataToSend->getMessageID();
-                    _dataToSend->clearAll();
-                    _unlock();
-                    // send the reply, but first add the CRC:
-                    // CRC calculation represents a bottleneck for large transmissions, and is anyway not needed with tcp or shared memory transmissions
-                    // crc=getCRC(&replyData[2],int(replyData.size()-2));
-                    crc=0;
-                    ((WORD*)&replyData[simx_headeroffset_crc])[0]=littleEndianWordConversion(crc,otherSideIsBigEndian);
-
-//printf("Trying to write...\n");
-                    if (!connection->replyToReceivedMessage(&replyData[0],(int)replyData.size()))
-                    {
-//printf("Write NOT successful!\n");
-                        if (_debug)
-                        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
-                            _lock(); // important to lock resources!
-                            _textToPrintToConsole.push_back("failed sending reply.\n");
-                            _unlock();
-                        }
+                    if (!_serveMessage(connection,_receivedCommands,_dataToSend,data,dataSize))
                         break;
-                    }
-                    else
-                    {
-//printf("Write successful!\n");
-                        _lastSentMessage_time=getTimeInMs();
-                        if (_debug)
-                        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
-                            _lock(); // important to lock resources!
-                            std::stringstream strStream;
-                            strStream << "reply sent: " << replyData.size() << " bytes (message ID = " << messageIdToSend << ", stream cmd cnt = " << streamCmdCnt << ")\n";
-                            _textToPrintToConsole.push_back(strStream.str());
-                            _unlock();
-                        }
-                    }
-                    if (killConnectionCommand)
-                        break; // since 13/12/2013
                 }
                 else
                 {
@@ -559,6 +711,139 @@ void* CSimxSocket::_run()
     return(NULL);
 }
 
+bool CSimxSocket::_serveMessage(CInConnection* conn,CSimxContainer* receivedCommands,CSimxContainer* dataToSend,char* data,int dataSize)
+{ // Parses and executes a received message, then sends the reply. Return value false means: disconnect the client
+    _lastReceivedMessage_time=getTimeInMs();
+    _successiveReception_time=_lastReceivedMessage_time-_previousReceivedMessage_time;
+    _previousReceivedMessage_time=_lastReceivedMessage_time;
+
+    otherSideIsBigEndian=conn->isOtherSideBigEndian();
+    // a) check the CRC:
+    WORD crc=littleEndianWordConversion(((WORD*)(data+simx_headeroffset_crc))[0],otherSideIsBigEndian);
+    _lock();
+    _lastReceivedMessage_cmdCnt=0;
+    bool killConnectionCommand=false;
+    // CRC calculation represents a bottleneck for large transmissions, and is anyway not needed with tcp or shared memory transmissions
+    // if (getCRC(data+2,dataSize-2)==crc)
+    if (true)
+    {
+        _lastReceivedMessage_clientVersion=data[simx_headeroffset_version];
+        receivedCommands->setOtherSideIsBigEndian(otherSideIsBigEndian);
+        dataToSend->setOtherSideIsBigEndian(otherSideIsBigEndian);
+        int messageID=littleEndianIntConversion(((int*)(data+simx_headeroffset_message_id))[0],otherSideIsBigEndian);
+        int timeStamp=littleEndianIntConversion(((int*)(data+simx_headeroffset_client_time))[0],otherSideIsBigEndian);
+        receivedCommands->setMessageID(messageID);
+        receivedCommands->setDataTimeStamp(timeStamp);
+        if (_debug)
+        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
+            // resources are already locked here, no need to lock a second time!
+            std::stringstream strStream;
+            strStream << "data received: " << dataSize << " bytes (message ID = " << messageID << ")\n";
+            _textToPrintToConsole.push_back(strStream.str());
+        }
+        int off=SIMX_HEADER_SIZE;
+        while (off<dataSize)
+        {
+            int cmdSize=littleEndianIntConversion(((int*)(data+off+simx_cmdheaderoffset_mem_size))[0],otherSideIsBigEndian);
+            int fullCmdSize=littleEndianIntConversion(((int*)(data+off+simx_cmdheaderoffset_full_mem_size))[0],otherSideIsBigEndian);
+            if (cmdSize!=fullCmdSize)
+            {
+                char* fullCommand=receivedCommands->addPartialCommand(data+off,otherSideIsBigEndian);
+                if (fullCommand!=NULL)
+                {
+                    int localCmdSize=littleEndianIntConversion(((int*)(fullCommand+simx_cmdheaderoffset_mem_size))[0],otherSideIsBigEndian);
+                    int cmd=littleEndianIntConversion(((int*)(fullCommand+simx_cmdheaderoffset_cmd))[0],otherSideIsBigEndian);
+                    killConnectionCommand=(cmd==simx_cmd_kill_connection);
+                    BYTE options=fullCommand[simx_cmdheaderoffset_status]; // bit0 set: do not overwrite this command!
+                    WORD delayOrSplit=littleEndianWordConversion(((WORD*)(fullCommand+simx_cmdheaderoffset_delay_or_split))[0],otherSideIsBigEndian);
+                    CSimxCmd* newCmd=new CSimxCmd(cmd,delayOrSplit,localCmdSize-SIMX_SUBHEADER_SIZE,fullCommand+SIMX_SUBHEADER_SIZE);
+                    newCmd->setSendOnlyOnChange((options&SIMX_CMDOPTION_SENDONLYONCHANGE)!=0);
+                    newCmd->setDeltaEncoding((options&SIMX_CMDOPTION_DELTAENCODING)!=0);
+                    newCmd->setCompression((options&SIMX_CMDOPTION_COMPRESSION)!=0);
+                    receivedCommands->addCommand(newCmd,options&1);
+                    delete[] fullCommand;
+                }
+            }
+            else
+            {
+                int cmd=littleEndianIntConversion(((int*)(data+off+simx_cmdheaderoffset_cmd))[0],otherSideIsBigEndian);
+                killConnectionCommand=(cmd==simx_cmd_kill_connection);
+                BYTE options=data[off+simx_cmdheaderoffset_status]; // bit0 set: do not overwrite this command!
+                WORD delayOrSplit=littleEndianWordConversion(((WORD*)(data+off+simx_cmdheaderoffset_delay_or_split))[0],otherSideIsBigEndian);
+                CSimxCmd* newCmd=new CSimxCmd(cmd,delayOrSplit,cmdSize-SIMX_SUBHEADER_SIZE,data+off+SIMX_SUBHEADER_SIZE);
+                newCmd->setSendOnlyOnChange((options&SIMX_CMDOPTION_SENDONLYONCHANGE)!=0);
+                newCmd->setDeltaEncoding((options&SIMX_CMDOPTION_DELTAENCODING)!=0);
+                newCmd->setCompression((options&SIMX_CMDOPTION_COMPRESSION)!=0);
+                receivedCommands->addCommand(newCmd,options&1);
+            }
+            off+=cmdSize;
+            _lastReceivedMessage_cmdCnt++;
+        }
+    }
+    else
+    {
+        if (_debug)
+        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
+            // resources are already locked here, no need to lock a second time!
+            _textToPrintToConsole.push_back("data received: error (crc failed)\n");
+        }
+    }
+    // data belongs to conn (it is reused for the next message)
+    // Prepare the reply. We first compute its exact size, then serialize it in one go. With shared memory, we try to
+    // write it directly to the shared memory, otherwise into _replyData, which only grows (no allocation once streaming is steady):
+    int streamCmdCnt=dataToSend->getStreamCommandCount();
+    int mainDataSize=dataToSend->getDataStringSize();
+    int replySize=mainDataSize+receivedCommands->getDataStringOfSplitOrGradualCommandsSize();
+    char* reply=conn->getReplyBuffer(replySize);
+    bool replyIsInPlace=(reply!=NULL);
+    if (!replyIsInPlace)
+    {
+        if (int(_replyData.size())<replySize)
+            _replyData.resize(replySize);
+        reply=&_replyData[0];
+    }
+    _lastSentMessage_cmdCnt=dataToSend->writeDataString(reply,otherSideIsBigEndian);
+    _lastSentMessage_cmdCnt+=receivedCommands->writeDataStringOfSplitOrGradualCommands(reply+mainDataSize,otherSideIsBigEndian);
+    int messageIdToSend=dataToSend->getMessageID();
+    dataToSend->clearAll();
+    _unlock();
+    // send the reply, but first add the CRC:
+    // CRC calculation represents a bottleneck for large transmissions, and is anyway not needed with tcp or shared memory transmissions
+    // crc=getCRC(reply+2,replySize-2);
+    crc=0;
+    ((WORD*)(reply+simx_headeroffset_crc))[0]=littleEndianWordConversion(crc,otherSideIsBigEndian);
+
+//printf("Trying to write...\n");
+    bool sent;
+    if (replyIsInPlace)
+        sent=conn->replyWithReplyBuffer(replySize);
+    else
+        sent=conn->replyToReceivedMessage(reply,replySize);
+    if (!sent)
+    {
+//printf("Write NOT successful!\n");
+        if (_debug)
+        { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
+            _lock(); // important to lock resources!
+            _textToPrintToConsole.push_back("failed sending reply.\n");
+            _unlock();
+        }
+        return(false);
+    }
+//printf("Write successful!\n");
+    _lastSentMessage_time=getTimeInMs();
+    _lastSentMessage_syscallCnt=conn->getLastReplySyscallCount();
+    if (_debug)
+    { // We do this in a funny way since we should not access V-REP from a thread not created in V-REP!
+        _lock(); // important to lock resources!
+        std::stringstream strStream;
+        strStream << "reply sent: " << replySize << " bytes (message ID = " << messageIdToSend << ", stream cmd cnt = " << streamCmdCnt << ")\n";
+        _textToPrintToConsole.push_back(strStream.str());
+        _unlock();
+    }
+    return(!killConnectionCommand); // since 13/12/2013
+}
+
 void CSimxSocket::addErrorString(const char* err)
 {
     if (_last50Errors.size()>=50)
@@ -594,6 +879,20 @@ void CSimxSocket::thereWasARequestToCallTheMainScript()
 
 std::string CSimxSocket::getConnectedMachineIP()
 {
+    if (_eventLoopMode)
+    {
+        std::string retVal;
+        _lock();
+        for (unsigned int i=0;i<_clients.size();i++)
+        {
+            if (i!=0)
+                retVal+=",";
+            retVal+=_clients[i]->connection->getConnectedMachineIP();
+        }
+        _unlock();
+        if (retVal.length()!=0)
+            return(retVal);
+    }
     if (connection)
         return connection->getConnectedMachineIP();
     else
@@ -9,6 +9,15 @@
     #include <pthread.h>
 #endif /* __linux || __APPLE__ */
 
+#define SIMX_LISTEN_RETRY_INTERVAL 1000 // in ms. Event loop mode: how often we try again to listen on a port that wasn't available
+
+struct SSimxClient
+{ // event loop mode: each accepted client has its own containers
+    CInConnection* connection;
+    CSimxContainer* receivedCommands;
+    CSimxContainer* dataToSend;
+};
+
 class CSimxSocket
 {
 public:
@@ -20,7 +29,7 @@ public:
     void thereWasARequestToCallTheMainScript();
     void instancePass();
 
-    void getInfo(int info[5]);
+    void getInfo(int info[6]);
     int getClientVersion();
     int getStatus();
     int getPortNb();
@@ -28,6 +37,27 @@ public:
     bool getContinuousService();
     bool getDebug();
     int getMaxPacketSize();
+    bool getUsesEventLoop();
+    void setMultiClient(bool m);
+    bool getMultiClient();
+    void setUnixSocketPath(const char* path);
+    std::string getUnixSocketPath();
+    void setSocketOptions(const SSocketOptions& options);
+    SSocketOptions getSocketOptions();
+
+#if defined (__linux) || defined (__APPLE__)
+    bool retryListening();
+
+    // Event loop mode (called from the CSimxReactor thread):
+    _SOCKET getListeningSocket();
+    bool getAcceptsMoreClients();
+    _SOCKET acceptClient();
+    bool serveClient(_SOCKET s);
+    bool sendUnsentReply(_SOCKET s);
+    bool getClientHasUnsentReply(_SOCKET s);
+    void disconnectClient(_SOCKET s);
+    bool getIsExecutingCommands();
+#endif /* __linux || __APPLE__ */
 
 
     void setWaitForTrigger(bool w);
@@ -41,6 +71,7 @@ public:
     std::string getConnectedMachineIP();
 
     static bool useAlternateSocketRoutines;
+    static bool useEventLoop;
 
 protected:
     void* _run();
@@ -48,12 +79,23 @@ protected:
     void _unlock();
 
     void _stop();
+#if defined (__linux) || defined (__APPLE__)
+    bool _startListening();
+#endif /* __linux || __APPLE__ */
     void _executeCommands();
+    bool _serveMessage(CInConnection* conn,CSimxContainer* receivedCommands,CSimxContainer* dataToSend,char* data,int dataSize);
+    int _getClientIndex(_SOCKET s);
+    void _deleteClient(SSimxClient* client);
 
     volatile bool _commThreadLaunched;
     volatile bool _commThreadEnded;
     volatile bool clientIsConnected;
+    volatile bool _executingCommands; // event loop mode: the main thread holds (or waits for) the lock to execute the commands
     bool otherSideIsBigEndian;
+    bool _eventLoopMode;
+    bool _multiClient;
+    std::string _unixSocketPath;
+    SSocketOptions _socketOptions;
     int _portNb;
     bool _simulationOnly;
     bool _continuousService;
@@ -69,16 +111,21 @@ protected:
     int _lastReceivedMessage_clientVersion;
     int _lastSentMessage_time;
     int _successiveReception_time;
+    int _previousReceivedMessage_time;
     int _lastReceivedMessage_cmdCnt;
     int _lastSentMessage_cmdCnt;
+    int _lastSentMessage_syscallCnt; // send system calls needed for the last reply (sockets only)
+    DWORD _lastListenAttemptTime; // event loop mode
 
     std::vector<std::string> _textToPrintToConsole;
     std::vector<std::string> _last50Errors;
+    std::vector<char> _replyData; // reused for every reply that can't be written in place, so that its capacity persists across messages
     
     CSimxContainer* _receivedCommands;
     CSimxContainer* _dataToSend;
 
-    CInConnection* connection;
+    CInConnection* connection; // in event loop mode, this one only listens
+    std::vector<SSimxClient*> _clients; // event loop mode
 
     int _lockLevel;
 #ifdef _WIN32
@@ -1,4 +1,11 @@
 #include "simxUtils.h"
+#include <string.h>
+
+#define SIMX_LZ4_HASH_LOG 12
+#define SIMX_LZ4_MIN_MATCH 4
+#define SIMX_LZ4_LAST_LITERALS 5 // the block ends with at least that many literals
+#define SIMX_LZ4_MATCH_FIND_LIMIT 12 // the last match starts at least that many bytes before the block end
+#define SIMX_LZ4_MAX_OFFSET 65535
 
 short littleEndianShortConversion(short v,bool otherSideIsBigEndian)
 {
@@ -83,3 +90,87 @@ WORD getCRC(const char* data,int length)
     }
     return(crc);
 }
+
+unsigned int getHash(const char* data,int length,unsigned int previousHash)
+{ // FNV-1a. Pass the previous return value to hash several buffers as one
+    unsigned int hash=previousHash;
+    for (int i=0;i<length;i++)
+    {
+        hash^=(BYTE)data[i];
+        hash*=16777619u;
+    }
+    return(hash);
+}
+
+static BYTE* _lz4WriteLength(BYTE* dest,int length)
+{ // length extension bytes, after the 15 stored in the token
+    length-=15;
+    while (length>=255)
+    {
+        *dest++=255;
+        length-=255;
+    }
+    *dest++=BYTE(length);
+    return(dest);
+}
+
+static BYTE* _lz4WriteSequence(BYTE* dest,const BYTE* destEnd,const BYTE* literals,int literalLength,int offset,int matchLength)
+{ // matchLength is 0 for the last sequence (literals only). Returns NULL if dest is too small
+    if (dest+1+literalLength/255+1+literalLength+2+matchLength/255+1>destEnd)
+        return(NULL);
+    BYTE* token=dest++;
+    *token=BYTE(((literalLength<15)?literalLength:15)<<4);
+    if (literalLength>=15)
+        dest=_lz4WriteLength(dest,literalLength);
+    memcpy(dest,literals,literalLength);
+    dest+=literalLength;
+    if (matchLength>0)
+    {
+        *dest++=BYTE(offset&255);
+        *dest++=BYTE(offset>>8);
+        matchLength-=SIMX_LZ4_MIN_MATCH;
+        *token|=BYTE((matchLength<15)?matchLength:15);
+        if (matchLength>=15)
+            dest=_lz4WriteLength(dest,matchLength);
+    }
+    return(dest);
+}
+
+int lz4Compress(const char* data,int length,char* dest,int destCapacity)
+{ // LZ4 block format (greedy, single hash probe), decodable with LZ4_decompress_safe. Returns the compressed size, or 0 if dest is too small
+    const BYTE* src=(const BYTE*)data;
+    BYTE* dst=(BYTE*)dest;
+    const BYTE* dstEnd=dst+destCapacity;
+    int hashTable[1<<SIMX_LZ4_HASH_LOG];
+    memset(hashTable,0xff,sizeof(hashTable)); // -1: no position yet
+    int anchor=0;
+    int pos=0;
+    int searchCount=1<<6;
+    int matchLimit=length-SIMX_LZ4_LAST_LITERALS;
+    while (pos+SIMX_LZ4_MATCH_FIND_LIMIT<=length)
+    {
+        unsigned int sequence;
+        memcpy(&sequence,src+pos,4);
+        unsigned int h=(sequence*2654435761u)>>(32-SIMX_LZ4_HASH_LOG);
+        int ref=hashTable[h];
+        hashTable[h]=pos;
+        if ((ref<0)||(pos-ref>SIMX_LZ4_MAX_OFFSET)||(memcmp(src+ref,src+pos,SIMX_LZ4_MIN_MATCH)!=0))
+        { // no match. Skip faster and faster through incompressible data
+            pos+=searchCount++>>6;
+            continue;
+        }
+        int matchLength=SIMX_LZ4_MIN_MATCH;
+        while ((pos+matchLength<matchLimit)&&(src[ref+matchLength]==src[pos+matchLength]))
+            matchLength++;
+        dst=_lz4WriteSequence(dst,dstEnd,src+anchor,pos-anchor,pos-ref,matchLength);
+        if (dst==NULL)
+            return(0);
+        pos+=matchLength;
+        anchor=pos;
+        searchCount=1<<6;
+    }
+    dst=_lz4WriteSequence(dst,dstEnd,src+anchor,length-anchor,0,0);
+    if (dst==NULL)
+        return(0);
+    return(int(dst-(BYTE*)dest));
+}
@@ -8,3 +8,5 @@ int littleEndianIntConversion(int v,bool otherSideIsBigEndian);
 float littleEndianFloatConversion(float v,bool otherSideIsBigEndian);
 double littleEndianDoubleConversion(double v,bool otherSideIsBigEndian);
 WORD getCRC(const char* data,int length);
+unsigned int getHash(const char* data,int length,unsigned int previousHash=2166136261u);
+int lz4Compress(const char* data,int length,char* dest,int destCapacity);
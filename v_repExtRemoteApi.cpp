@@ -164,12 +164,18 @@ void LUA_RESET_CALLBACK(SScriptCallBack* p)
             bool debug=s->getDebug();
             int maxPacketS=s->getMaxPacketSize();
             bool triggerPreEnabled=s->getWaitForTriggerAuthorized();
+            bool multiClient=s->getMultiClient();
+            std::string unixSocketPath=s->getUnixSocketPath();
+            SSocketOptions socketOptions=s->getSocketOptions();
 
             // Kill the thread/connection:
             allConnections.removeSocketConnection(s);
                 
             // Now create a similar thread/connection:
             CSimxSocket* oneSocketConnection=new CSimxSocket(port,continuous,simulOnly,debug,maxPacketS,triggerPreEnabled);
+            oneSocketConnection->setMultiClient(multiClient);
+            oneSocketConnection->setUnixSocketPath(unixSocketPath.c_str());
+            oneSocketConnection->setSocketOptions(socketOptions);
             oneSocketConnection->start();
             allConnections.addSocketConnection(oneSocketConnection);
             
@@ -198,9 +204,9 @@ void LUA_STATUS_CALLBACK(SScriptCallBack* p)
 {
     CScriptFunctionData D;
     int result=-1;
-    std::vector<int> info(5,0);
+    std::vector<int> info(6,0);
     int clientVersion=-1;
-    char connectedMachineIP[200]="";
+    std::string connectedMachineIP;
     if (D.readDataFromStack(p->stackID,inArgs_STATUS,inArgs_STATUS[0],LUA_STATUS_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
@@ -211,7 +217,7 @@ void LUA_STATUS_CALLBACK(SScriptCallBack* p)
             result=s->getStatus();
             s->getInfo(&info[0]);
             clientVersion=s->getClientVersion();
-            strcpy(connectedMachineIP,s->getConnectedMachineIP().c_str());
+            connectedMachineIP=s->getConnectedMachineIP(); // comma separated when several clients share the port
         }
     }
     D.pushOutData(CScriptFunctionDataItem(result));
@@ -222,7 +228,7 @@ void LUA_STATUS_CALLBACK(SScriptCallBack* p)
     D.pushOutData(CScriptFunctionDataItem(SIMX_VERSION));
     D.pushOutData(CScriptFunctionDataItem(clientVersion));
     if (result>-1)
-        D.pushOutData(CScriptFunctionDataItem(std::string(connectedMachineIP)));
+        D.pushOutData(CScriptFunctionDataItem(connectedMachineIP));
 
     D.writeDataToStack(p->stackID);
 }
@@ -285,7 +291,7 @@ VREP_DLLEXPORT unsigned char v_repStart(void* reservedPointer,int reservedInt)
     simRegisterScriptCallbackFunction(strConCat(LUA_START_COMMAND,"@","RemoteApi"),strConCat("number result=",LUA_START_COMMAND,"(number socketPort,number maxPacketSize=1300,boolean debug=false,boolean preEnableTrigger=false)"),LUA_START_CALLBACK);
     simRegisterScriptCallbackFunction(strConCat(LUA_STOP_COMMAND,"@","RemoteApi"),strConCat("number result=",LUA_STOP_COMMAND,"(number socketPort)"),LUA_STOP_CALLBACK);
     simRegisterScriptCallbackFunction(strConCat(LUA_RESET_COMMAND,"@","RemoteApi"),strConCat("number result=",LUA_RESET_COMMAND,"(number socketPort)"),LUA_RESET_CALLBACK);
-    simRegisterScriptCallbackFunction(strConCat(LUA_STATUS_COMMAND,"@","RemoteApi"),strConCat("number status,table_5 info,number version,number clientVersion,string connectedIp=",LUA_STATUS_COMMAND,"(number socketPort)"),LUA_STATUS_CALLBACK);
+    simRegisterScriptCallbackFunction(strConCat(LUA_STATUS_COMMAND,"@","RemoteApi"),strConCat("number status,table_6 info,number version,number clientVersion,string connectedIp=",LUA_STATUS_COMMAND,"(number socketPort)"),LUA_STATUS_CALLBACK);
 
     // Following for backward compatibility:
     simRegisterScriptVariable(LUA_START_COMMANDOLD,LUA_START_COMMAND,-1);
@@ -311,6 +317,7 @@ VREP_DLLEXPORT unsigned char v_repStart(void* reservedPointer,int reservedInt)
     // Read the configuration file and start remote API server services accordingly:
     conf.readConfiguration(temp.c_str());
     conf.getBoolean("useAlternateSocketRoutines",CSimxSocket::useAlternateSocketRoutines);
+    conf.getBoolean("useEventLoop",CSimxSocket::useEventLoop); // one thread polls all socket ports (Linux only)
 
     int index=1;
     while (true)
@@ -329,12 +336,31 @@ VREP_DLLEXPORT unsigned char v_repStart(void* reservedPointer,int reservedInt)
                 maxPacketSize=3200000;
 
             bool synchronousTrigger=false;
+            bool multiClient=false;
             variableName=variableNameBase+"_maxPacketSize";
             conf.getInteger(variableName.c_str(),maxPacketSize);
             variableName=variableNameBase+"_debug";
             conf.getBoolean(variableName.c_str(),debug);
             variableName=variableNameBase+"_syncSimTrigger";
             conf.getBoolean(variableName.c_str(),synchronousTrigger);
+            variableName=variableNameBase+"_multiClient";
+            conf.getBoolean(variableName.c_str(),multiClient); // several clients on this port (implies event loop mode)
+            std::string unixSocketPath;
+            variableName=variableNameBase+"_path";
+            conf.getString(variableName.c_str(),unixSocketPath); // listen on that Unix domain socket instead of the TCP port (Linux and macOS)
+            SSocketOptions socketOptions;
+            socketOptions.noDelay=false;
+            socketOptions.quickAck=false;
+            socketOptions.rcvBuf=0;
+            socketOptions.sndBuf=0;
+            variableName=variableNameBase+"_noDelay";
+            conf.getBoolean(variableName.c_str(),socketOptions.noDelay);
+            variableName=variableNameBase+"_quickAck";
+            conf.getBoolean(variableName.c_str(),socketOptions.quickAck); // Linux only
+            variableName=variableNameBase+"_rcvBuf";
+            conf.getInteger(variableName.c_str(),socketOptions.rcvBuf); // in bytes. 0 keeps the system default
+            variableName=variableNameBase+"_sndBuf";
+            conf.getInteger(variableName.c_str(),socketOptions.sndBuf); // in bytes. 0 keeps the system default
 
             if (portNb<0)
             { // when using shared memory
@@ -354,6 +380,12 @@ VREP_DLLEXPORT unsigned char v_repStart(void* reservedPointer,int reservedInt)
             if (allConnections.getConnectionFromPort(portNb)==NULL)
             {
                 CSimxSocket* oneSocketConnection=new CSimxSocket(portNb,true,false,debug,maxPacketSize,synchronousTrigger);
+                oneSocketConnection->setMultiClient(multiClient);
+                if (multiClient&&(!oneSocketConnection->getMultiClient()))
+                    std::cout << "Ignoring " << variableNameBase << "_multiClient: several clients per port are only supported on Linux, with sockets" << std::endl;
+                if (portNb>=0)
+                    oneSocketConnection->setUnixSocketPath(unixSocketPath.c_str());
+                oneSocketConnection->setSocketOptions(socketOptions);
                 oneSocketConnection->start();
                 allConnections.addSocketConnection(oneSocketConnection);
                 std::cout << "Starting a remote API server on port " << portNb << std::endl;
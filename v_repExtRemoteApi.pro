@@ -7,6 +7,7 @@ TEMPLATE = lib
 DEFINES -= UNICODE
 DEFINES += QT_COMPIL
 CONFIG += shared
+CONFIG += c++11
 INCLUDEPATH += "../include"
 
 *-msvc* {
@@ -58,7 +59,9 @@ SOURCES += \
     porting.cpp \
     simxCmd.cpp \
     simxConnections.cpp \
+    simxReactor.cpp \
     simxContainer.cpp \
+    simxImage.cpp \
     simxSocket.cpp \
     simxUtils.cpp \
     ../common/scriptFunctionData.cpp \
@@ -73,7 +76,9 @@ HEADERS +=\
     porting.h \
     simxCmd.h \
     simxConnections.h \
+    simxReactor.h \
     simxContainer.h \
+    simxImage.h \
     simxSocket.h \
     simxUtils.h \
     ../include/scriptFunctionData.h \